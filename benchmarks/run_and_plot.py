@@ -16,6 +16,20 @@ algorithms = {
     "dir24_8": "dir_24_8.cpp",
     "dxr": "dxr.cpp",
     "dxr_bloom": "dxr_bloom.cpp",
+    "dxr_range": "dxr_range.cpp",
+    "poptrie": "poptrie.cpp",
+    "tree_bitmap": "tree_bitmap.cpp",
+    "lc_trie": "lc_trie.cpp",
+    "sail": "sail.cpp",
+    "lulea": "lulea.cpp",
+    "bspl": "bspl.cpp",
+    "bloom_lpm": "bloom_lpm.cpp",
+    "eytzinger": "eytzinger.cpp",
+    "stree": "stree.cpp",
+    "art": "art.cpp",
+    "learned": "learned.cpp",
+    "dir24_8_tagged": "dir_24_8_tagged.cpp",
+    "vsdir": "vsdir.cpp",
 }
 results_files = {
     "radix": os.path.join(BENCH_DIR, "results_radix.csv"),
@@ -23,6 +37,20 @@ results_files = {
     "dir24_8": os.path.join(BENCH_DIR, "results_dir24_8.csv"),
     "dxr": os.path.join(BENCH_DIR, "results_dxr.csv"),
     "dxr_bloom": os.path.join(BENCH_DIR, "results_dxr_bloom.csv"),
+    "dxr_range": os.path.join(BENCH_DIR, "results_dxr_range.csv"),
+    "poptrie": os.path.join(BENCH_DIR, "results_poptrie.csv"),
+    "tree_bitmap": os.path.join(BENCH_DIR, "results_tree_bitmap.csv"),
+    "lc_trie": os.path.join(BENCH_DIR, "results_lc.csv"),
+    "sail": os.path.join(BENCH_DIR, "results_sail.csv"),
+    "lulea": os.path.join(BENCH_DIR, "results_lulea.csv"),
+    "bspl": os.path.join(BENCH_DIR, "results_bspl.csv"),
+    "bloom_lpm": os.path.join(BENCH_DIR, "results_bloom_lpm.csv"),
+    "eytzinger": os.path.join(BENCH_DIR, "results_eytzinger.csv"),
+    "stree": os.path.join(BENCH_DIR, "results_stree.csv"),
+    "art": os.path.join(BENCH_DIR, "results_art.csv"),
+    "learned": os.path.join(BENCH_DIR, "results_learned.csv"),
+    "dir24_8_tagged": os.path.join(BENCH_DIR, "results_dir24_8_tagged.csv"),
+    "vsdir": os.path.join(BENCH_DIR, "results_vsdir.csv"),
 }
 
 def run_cmd(cmd, cwd=None):
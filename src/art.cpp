@@ -0,0 +1,510 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <unistd.h>   // sysconf
+#include <cstdint>
+#include <algorithm>
+#include "mt_lookup.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// Adaptive Radix Tree (Leis/Kemper/Neumann) for IPv4 LPM, one address byte
+/// per level (at most 4 levels). Nodes grow Node4 -> Node16 -> Node48 ->
+/// Node256 with their real fan-out; Node16 is searched with one SSE2 compare
+/// and Node48 through a 256-byte index. Prefixes are expanded over the byte
+/// values they cover inside the node of the byte they end in, and chains of
+/// single-child levels are collapsed into the node's compressed path.
+///
+/// Usage:
+///   Fast mode (default):   ./src/art
+///   Check mode (hex out):  ./src/art -chk
+
+// ------------------------- Paths -------------------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_art.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_art.csv";
+
+// ------------------------- Helpers -----------------------
+static inline uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+static inline uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& hex) {
+    std::vector<uint8_t> out;
+    out.reserve(hex.size() / 2);
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        out.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const std::vector<uint8_t>& bytes) {
+    std::ostringstream oss;
+    for (auto b : bytes)
+        oss << std::hex << std::setw(2) << std::setfill('0') << int(b);
+    return oss.str();
+}
+static inline bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+static inline auto now() { return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+static inline size_t current_rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double bytes_to_mb(size_t b) { return double(b) / (1024.0 * 1024.0); }
+
+// ------------------------- Data --------------------------
+// One byte of the address per level. A slot holds the best prefix ending in
+// this byte (expanded over the byte values it covers) and the next-level node.
+struct Slot {
+    struct Node* child = nullptr;
+    uint32_t value = 0;       // key id, 0 = none
+    uint8_t value_len = 0;    // prefix length of `value`
+};
+
+enum NodeType : uint8_t { N4, N16, N48, N256 };
+
+// Path compression: `prefix` holds the prefix_len bytes between the parent's
+// byte and this node's byte (depth - prefix_len .. depth - 1).
+struct Node {
+    NodeType type;
+    uint8_t depth;            // address byte this node dispatches on (0..3)
+    uint8_t prefix_len;
+    uint8_t prefix[3];
+    uint16_t count = 0;
+    Node(NodeType t, uint8_t d) : type(t), depth(d), prefix_len(0), prefix{} {}
+};
+struct Node4 : Node {
+    uint8_t keys[4];
+    Slot slots[4];
+    explicit Node4(uint8_t d) : Node(N4, d) {}
+};
+struct Node16 : Node {
+    uint8_t keys[16];
+    Slot slots[16];
+    explicit Node16(uint8_t d) : Node(N16, d) {}
+};
+struct Node48 : Node {
+    uint8_t index[256] = {};  // slot + 1, 0 = empty
+    Slot slots[48];
+    explicit Node48(uint8_t d) : Node(N48, d) {}
+};
+struct Node256 : Node {
+    Slot slots[256];
+    explicit Node256(uint8_t d) : Node(N256, d) {}
+};
+
+static inline uint8_t addr_byte(uint32_t a, int i) { return uint8_t(a >> (24 - 8 * i)); }
+
+class AdaptiveRadixTree {
+public:
+    AdaptiveRadixTree() : root_(new Node256(0)) { ++n256_; }
+    ~AdaptiveRadixTree() { destroy(root_); }
+    AdaptiveRadixTree(const AdaptiveRadixTree&) = delete;
+    AdaptiveRadixTree& operator=(const AdaptiveRadixTree&) = delete;
+
+    void insert(uint32_t net, uint8_t len, std::vector<uint8_t>&& key) {
+        keys_.push_back(std::move(key));
+        uint32_t id = uint32_t(keys_.size());   // 1-based, 0 = no match
+        ++inserted_;
+        net &= mask_from_len(len);
+        if (len == 0) { default_ = id; return; }
+
+        const int t = (len - 1) / 8;            // byte the prefix ends in
+        Node** ref = &root_;
+        for (;;) {
+            Node* n = *ref;
+            // split the compressed path where it diverges or where the prefix ends
+            int first = n->depth - n->prefix_len;
+            for (int p = first; p < n->depth; ++p) {
+                if (p == t || addr_byte(net, p) != n->prefix[p - first]) {
+                    n = split(ref, p);
+                    break;
+                }
+            }
+
+            const int d = n->depth;
+            const uint8_t b = addr_byte(net, d);
+            if (t == d) {
+                // expand over every byte value the prefix covers
+                uint32_t span = 1u << (8 * (d + 1) - len);
+                for (uint32_t v = b; v < b + span; ++v) {
+                    Slot* s = find_or_add(ref, uint8_t(v));
+                    if (s->value_len <= len) { s->value = id; s->value_len = len; }
+                }
+                return;
+            }
+            Slot* s = find_or_add(ref, b);
+            if (!s->child) s->child = new_leaf_path(net, d + 1, t);
+            ref = &s->child;
+        }
+    }
+
+    const std::vector<uint8_t>* lpm(uint32_t ip) const {
+        uint32_t best = default_;
+        const Node* n = root_;
+        while (n) {
+            int first = n->depth - n->prefix_len;
+            for (int p = first; p < n->depth; ++p)
+                if (addr_byte(ip, p) != n->prefix[p - first]) return key_of(best);
+            const Slot* s = find(n, addr_byte(ip, n->depth));
+            if (!s) break;
+            if (s->value) best = s->value;
+            n = s->child;
+        }
+        return key_of(best);
+    }
+
+    size_t inserted() const { return inserted_; }
+    size_t n4() const { return n4_; }
+    size_t n16() const { return n16_; }
+    size_t n48() const { return n48_; }
+    size_t n256() const { return n256_; }
+    size_t node_bytes() const {
+        return n4_ * sizeof(Node4) + n16_ * sizeof(Node16)
+             + n48_ * sizeof(Node48) + n256_ * sizeof(Node256);
+    }
+
+private:
+    Node* root_;
+    uint32_t default_ = 0;
+    std::vector<std::vector<uint8_t>> keys_;
+    size_t inserted_ = 0;
+    size_t n4_ = 0, n16_ = 0, n48_ = 0, n256_ = 0;
+
+    const std::vector<uint8_t>* key_of(uint32_t id) const {
+        return id ? &keys_[id - 1] : nullptr;
+    }
+
+    static const Slot* find(const Node* n, uint8_t b) {
+        switch (n->type) {
+            case N4: {
+                auto* x = static_cast<const Node4*>(n);
+                for (int i = 0; i < x->count; ++i) if (x->keys[i] == b) return &x->slots[i];
+                return nullptr;
+            }
+            case N16: {
+                auto* x = static_cast<const Node16*>(n);
+#if defined(__SSE2__)
+                __m128i eq = _mm_cmpeq_epi8(_mm_set1_epi8(char(b)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(x->keys)));
+                uint32_t m = uint32_t(_mm_movemask_epi8(eq)) & ((1u << x->count) - 1);
+                return m ? &x->slots[__builtin_ctz(m)] : nullptr;
+#else
+                for (int i = 0; i < x->count; ++i) if (x->keys[i] == b) return &x->slots[i];
+                return nullptr;
+#endif
+            }
+            case N48: {
+                auto* x = static_cast<const Node48*>(n);
+                return x->index[b] ? &x->slots[x->index[b] - 1] : nullptr;
+            }
+            default: {
+                auto* x = static_cast<const Node256*>(n);
+                const Slot* s = &x->slots[b];
+                return (s->child || s->value) ? s : nullptr;
+            }
+        }
+    }
+
+    // Slot for byte b in *ref, adding it (and growing the node) if missing.
+    Slot* find_or_add(Node** ref, uint8_t b) {
+        if (Slot* s = const_cast<Slot*>(find(*ref, b))) return s;
+        Node* n = *ref;
+        switch (n->type) {
+            case N4: {
+                auto* x = static_cast<Node4*>(n);
+                if (x->count < 4) { x->keys[x->count] = b; return &x->slots[x->count++]; }
+                auto* y = new Node16(x->depth); ++n16_;
+                copy_header(y, x);
+                for (int i = 0; i < 4; ++i) { y->keys[i] = x->keys[i]; y->slots[i] = x->slots[i]; }
+                y->count = 4;
+                delete x; --n4_;
+                *ref = y;
+                return find_or_add(ref, b);
+            }
+            case N16: {
+                auto* x = static_cast<Node16*>(n);
+                if (x->count < 16) { x->keys[x->count] = b; return &x->slots[x->count++]; }
+                auto* y = new Node48(x->depth); ++n48_;
+                copy_header(y, x);
+                for (int i = 0; i < 16; ++i) { y->index[x->keys[i]] = uint8_t(i + 1); y->slots[i] = x->slots[i]; }
+                y->count = 16;
+                delete x; --n16_;
+                *ref = y;
+                return find_or_add(ref, b);
+            }
+            case N48: {
+                auto* x = static_cast<Node48*>(n);
+                if (x->count < 48) { x->index[b] = uint8_t(x->count + 1); return &x->slots[x->count++]; }
+                auto* y = new Node256(x->depth); ++n256_;
+                copy_header(y, x);
+                for (int v = 0; v < 256; ++v) if (x->index[v]) y->slots[v] = x->slots[x->index[v] - 1];
+                y->count = 48;
+                delete x; --n48_;
+                *ref = y;
+                return find_or_add(ref, b);
+            }
+            default: {
+                auto* x = static_cast<Node256*>(n);
+                ++x->count;
+                return &x->slots[b];
+            }
+        }
+    }
+
+    static void copy_header(Node* dst, const Node* src) {
+        dst->prefix_len = src->prefix_len;
+        for (int i = 0; i < 3; ++i) dst->prefix[i] = src->prefix[i];
+    }
+
+    // New Node4 at depth t, compressing the bytes from..t-1 of net into its path.
+    Node* new_leaf_path(uint32_t net, int from, int t) {
+        auto* n = new Node4(uint8_t(t)); ++n4_;
+        n->prefix_len = uint8_t(t - from);
+        for (int p = from; p < t; ++p) n->prefix[p - from] = addr_byte(net, p);
+        return n;
+    }
+
+    // Insert a Node4 at depth p inside *ref's compressed path; *ref becomes its child.
+    Node* split(Node** ref, int p) {
+        Node* n = *ref;
+        int first = n->depth - n->prefix_len;
+        auto* s = new Node4(uint8_t(p)); ++n4_;
+        s->prefix_len = uint8_t(p - first);
+        for (int i = 0; i < s->prefix_len; ++i) s->prefix[i] = n->prefix[i];
+        s->keys[0] = n->prefix[p - first];
+        s->slots[0].child = n;
+        s->count = 1;
+
+        uint8_t rest[3];
+        int k = 0;
+        for (int q = p + 1; q < n->depth; ++q) rest[k++] = n->prefix[q - first];
+        n->prefix_len = uint8_t(k);
+        for (int i = 0; i < k; ++i) n->prefix[i] = rest[i];
+
+        *ref = s;
+        return s;
+    }
+
+    static void destroy(Node* n) {
+        if (!n) return;
+        switch (n->type) {
+            case N4:   { auto* x = static_cast<Node4*>(n);   for (int i = 0; i < x->count; ++i) destroy(x->slots[i].child); delete x; break; }
+            case N16:  { auto* x = static_cast<Node16*>(n);  for (int i = 0; i < x->count; ++i) destroy(x->slots[i].child); delete x; break; }
+            case N48:  { auto* x = static_cast<Node48*>(n);  for (int i = 0; i < x->count; ++i) destroy(x->slots[i].child); delete x; break; }
+            default:   { auto* x = static_cast<Node256*>(n); for (int i = 0; i < 256; ++i) destroy(x->slots[i].child); delete x; break; }
+        }
+    }
+};
+
+struct PrefixRec {
+    uint32_t net;
+    uint8_t len;
+    std::vector<uint8_t> key; // will be moved into tree
+};
+
+// ------------------------- Benchmark ---------------------
+static int run(bool write_hex, int threads) {
+    // -------- Phase A: Load prefixes (batch) --------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line;
+    std::getline(pf, line); // header: prefix,key
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000);
+
+    size_t num_prefixes = 0;
+    while (std::getline(pf, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',') || !std::getline(ss, key_hex)) continue;
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        if (len > 32) continue;  // Skip invalid prefix lengths
+        uint32_t net = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        prefixes.push_back({net, len, hex_to_bytes(key_hex)});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // -------- Phase B: Build trie (incremental inserts) --------
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+
+    AdaptiveRadixTree art;
+    for (auto& rec : prefixes) {
+        art.insert(rec.net, rec.len, std::move(rec.key));
+    }
+    double build_ds_s = secs_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header: ip,used_prefix
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1<<20);
+    ip_strs.reserve(1<<20);
+
+    while (std::getline(ipf, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, dummy;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, dummy);
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // -------- Phase D: Lookup timing --------
+    auto tD0 = now();
+    std::vector<std::pair<std::string,std::string>> results;
+    results.reserve(ips.size());
+
+    for (size_t i = 0; i < ips.size(); ++i) {
+        const auto* key = art.lpm(ips[i]);
+        if (write_hex) {
+            results.emplace_back(ip_strs[i], key ? bytes_to_hex(*key) : std::string("-1"));
+        } else {
+            results.emplace_back(ip_strs[i], key ? std::string("1") : std::string("-1"));
+        }
+    }
+    double lookup_s = secs_since(tD0);
+
+    double ns_per_lookup = ips.empty() ? 0.0 : (lookup_s * 1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write matches --------
+    {
+        std::ofstream out(MATCH_FILE, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (auto& r : results) out << r.first << "," << r.second << "\n";
+        }
+    }
+
+    // -------- Final mem & write results CSV --------
+    size_t rss_total_bytes = current_rss_bytes();
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(rss_total_bytes);
+
+    std::string algo_name = "ART";
+    bool need_header = !file_exists(RESULTS_FILE);
+
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if (!res) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        res.setf(std::ios::fixed);
+        if (need_header) {
+            res << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                   "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                   "lookups_per_s,ns_per_lookup,"
+                   "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+                   "node4,node16,node48,node256,art_struct_mb\n";
+        }
+        res << algo_name << ","
+            << PREFIX_FILE << ","
+            << IP_FILE << ","
+            << num_prefixes << ","
+            << ips.size() << ","
+            << std::setprecision(6)
+            << prefix_load_s << ","
+            << build_ds_s << ","
+            << ip_load_s << ","
+            << lookup_s << ","
+            << std::setprecision(2)
+            << lookups_per_s << ","
+            << ns_per_lookup << ","
+            << std::setprecision(2)
+            << mem_prefix_array_mb << ","
+            << mem_ds_mb << ","
+            << mem_ip_array_mb << ","
+            << mem_total_mb << ","
+            << art.n4() << ","
+            << art.n16() << ","
+            << art.n48() << ","
+            << art.n256() << ","
+            << std::setprecision(4)
+            << bytes_to_mb(art.node_bytes())
+            << "\n";
+    }
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if (threads > 0)
+        mt::run_threads_benchmark(algo_name, ips, threads,
+                                  [&](uint32_t ip) { return art.lpm(ip) != nullptr; });
+
+    return 0;
+}
+
+// ------------------------- Main --------------------------
+int main(int argc, char* argv[]) {
+    bool write_hex = false;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-chk" || a == "--chk") write_hex = true;
+        else if ((a == "-threads" || a == "--threads") && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if (a == "-h" || a == "--help") {
+            std::cout <<
+                "Usage: " << argv[0] << " [-chk] [--threads N]\n"
+                "  -chk          Write hex keys to benchmarks/match_art.csv (slower)\n"
+                "  --threads N   Also measure lookup scaling on N pinned threads\n"
+                "                (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+    return run(write_hex, threads);
+}
@@ -9,16 +9,31 @@
 #include <unistd.h>   // sysconf
 #include <cstdint>
 #include <algorithm>
+#include <cctype>
+#include "mt_lookup.h"
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // AVX2 lockstep walker (compiled via target attribute)
+#define HAVE_X86_KERNELS 1
+#endif
 
 /// Usage:
 ///   Fast mode (default):   ./src/radix_trie
 ///   Check mode (hex out):  ./src/radix_trie -chk
+///   Interleaved lookups:   ./src/radix_trie -coro [N]   (needs -std=c++20)
+///   SIMD lockstep lookups: ./src/radix_trie -simd
+///   Thread scaling:        ./src/radix_trie --threads N
 
 // ------------------------- Paths -------------------------
 static const char* PREFIX_FILE   = "data/prefix_table.csv";
 static const char* IP_FILE       = "data/generated_ips.csv";
 static const char* MATCH_FILE    = "benchmarks/match_radix.csv";
 static const char* RESULTS_FILE  = "benchmarks/results_radix.csv";
+static const size_t CORO_WIDTH   = 16;      // default lookups in flight for -coro
+static const int    CORO_HOT_LEVELS = 12;   // top levels (~4k nodes) stay cached; no yield there
 
 // ------------------------- Helpers -----------------------
 static inline uint32_t ip_str_to_uint(const std::string& ip_str) {
@@ -64,6 +79,60 @@ struct Node {
     bool has_key = false;
     std::vector<uint8_t> key; // key only at prefix end
 };
+
+// Index-based copy of the trie for the lockstep walker, laid out in BFS order.
+// Node 0 is a null sentinel (no children, no key): a lane whose walk has
+// ended keeps gathering from it harmlessly. key_id indexes the key table
+// built alongside, where 0 means no key.
+struct FlatNode {
+    uint32_t child[2];
+    uint32_t key_id;
+    uint32_t pad;
+};
+static const uint32_t FLAT_ROOT = 1;
+
+#if defined(__cpp_impl_coroutine)
+// One suspended lookup. The coroutine suspends before it starts and again
+// after each prefetch; the scheduler resumes it once the other lookups in
+// flight have had their turn, by which time the node is (hopefully) in cache.
+// Frames all have the same size, so they are recycled through a free list
+// instead of going back to the allocator on every lookup.
+struct LpmTask {
+    struct promise_type {
+        const std::vector<uint8_t>* result = nullptr;
+
+        LpmTask get_return_object() {
+            return LpmTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(const std::vector<uint8_t>* r) { result = r; }
+        void unhandled_exception() { std::terminate(); }
+
+        struct FreeFrame { FreeFrame* next; };
+        static inline FreeFrame* free_list = nullptr;
+        static inline size_t frame_size = 0;
+
+        static void* operator new(size_t n) {
+            if (free_list && n == frame_size) {
+                FreeFrame* f = free_list;
+                free_list = f->next;
+                return f;
+            }
+            frame_size = n;
+            return ::operator new(n);
+        }
+        static void operator delete(void* p, size_t n) {
+            if (n != frame_size) { ::operator delete(p); return; }
+            auto* f = static_cast<FreeFrame*>(p);
+            f->next = free_list;
+            free_list = f;
+        }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+#endif
+
 class BinaryTrie {
 public:
     BinaryTrie() : root(new Node) {}
@@ -96,6 +165,81 @@ public:
         return best;
     }
 
+#if defined(__cpp_impl_coroutine)
+    // Same walk as lpm(), but below the cache-resident top levels it prefetches
+    // each child and yields before touching it. Yielding on hot nodes only
+    // adds switch overhead.
+    LpmTask lpm_coro(uint32_t ip) const {
+        const std::vector<uint8_t>* best = nullptr;
+        const Node* n = root;
+        if (n->has_key) best = &n->key;
+        for (int i = 0; i < 32; ++i) {
+            int bit = (ip >> (31 - i)) & 1;
+            n = n->child[bit];
+            if (!n) break;
+            if (i >= CORO_HOT_LEVELS) {
+                __builtin_prefetch(n);
+                co_await std::suspend_always{};
+            }
+            if (n->has_key) best = &n->key;
+        }
+        co_return best;
+    }
+
+    // Keeps `width` lookups in flight, round-robin resuming each one so that
+    // its prefetch overlaps with the others' work (AMAC-style interleaving).
+    void lpm_interleaved(const uint32_t* ips, size_t n, size_t width,
+                         const std::vector<uint8_t>** out) const {
+        struct Slot { std::coroutine_handle<LpmTask::promise_type> h; size_t idx; };
+        std::vector<Slot> slots(std::max<size_t>(1, width));
+        size_t next = 0, active = 0;
+        for (auto& s : slots) {
+            if (next == n) { s.h = nullptr; continue; }
+            s.idx = next;
+            s.h = lpm_coro(ips[next++]).handle;
+            ++active;
+        }
+        while (active) {
+            for (auto& s : slots) {
+                if (!s.h) continue;
+                s.h.resume();
+                if (!s.h.done()) continue;
+                out[s.idx] = s.h.promise().result;
+                s.h.destroy();
+                if (next < n) {
+                    s.idx = next;
+                    s.h = lpm_coro(ips[next++]).handle;
+                } else {
+                    s.h = nullptr;
+                    --active;
+                }
+            }
+        }
+    }
+#endif
+
+    // Flatten into `nodes` (sentinel at 0, root at FLAT_ROOT) and `keys`
+    // (keys[key_id], keys[0] = nullptr).
+    void export_flat(std::vector<FlatNode>& nodes,
+                     std::vector<const std::vector<uint8_t>*>& keys) const {
+        std::vector<const Node*> order{nullptr, root};
+        nodes.assign(2, FlatNode{{0, 0}, 0, 0});
+        keys.assign(1, nullptr);
+        for (size_t i = FLAT_ROOT; i < order.size(); ++i) {
+            const Node* n = order[i];
+            if (n->has_key) {
+                nodes[i].key_id = static_cast<uint32_t>(keys.size());
+                keys.push_back(&n->key);
+            }
+            for (int b = 0; b < 2; ++b) {
+                if (!n->child[b]) continue;
+                nodes[i].child[b] = static_cast<uint32_t>(order.size());
+                order.push_back(n->child[b]);
+                nodes.push_back(FlatNode{{0, 0}, 0, 0});
+            }
+        }
+    }
+
     size_t inserted() const { return inserted_; }
 
 private:
@@ -109,6 +253,54 @@ private:
     }
 };
 
+// ------------------------- Lockstep walker ---------------------------
+// Scalar walk over the flat array: the fallback without AVX2, and the tail.
+static inline uint32_t lpm_flat(const FlatNode* nodes, uint32_t ip) {
+    uint32_t best = nodes[FLAT_ROOT].key_id;
+    uint32_t cur = FLAT_ROOT;
+    for (int i = 0; i < 32; ++i) {
+        cur = nodes[cur].child[(ip >> (31 - i)) & 1];
+        if (!cur) break;
+        if (nodes[cur].key_id) best = nodes[cur].key_id;
+    }
+    return best;
+}
+
+static void lpm_flat_batch(const FlatNode* nodes, const uint32_t* ips, size_t n, uint32_t* out) {
+    for (size_t i = 0; i < n; ++i) out[i] = lpm_flat(nodes, ips[i]);
+}
+
+#ifdef HAVE_X86_KERNELS
+// Eight addresses walk the trie together, one level per iteration. All lanes
+// share the depth, so the branch bit is one shift. Each level takes one
+// gather for the child index and one for its key id. A lane retires when it
+// reaches the sentinel, and the loop ends once every lane has retired.
+// Gather indexes are signed 32-bit, which allows up to 2^29 nodes.
+__attribute__((target("avx2")))
+static void lpm_lockstep_avx2(const FlatNode* nodes, const uint32_t* ips, size_t n, uint32_t* out) {
+    const int*    base     = reinterpret_cast<const int*>(nodes);
+    const __m256i one      = _mm256_set1_epi32(1);
+    const __m256i key_off  = _mm256_set1_epi32(2);
+    const __m256i zero     = _mm256_setzero_si256();
+    const __m256i root_key = _mm256_set1_epi32(static_cast<int>(nodes[FLAT_ROOT].key_id));
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i ip   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ips + i));
+        __m256i cur  = _mm256_set1_epi32(static_cast<int>(FLAT_ROOT));
+        __m256i best = root_key;
+        for (int d = 0; d < 32; ++d) {
+            __m256i bit = _mm256_and_si256(_mm256_srl_epi32(ip, _mm_cvtsi32_si128(31 - d)), one);
+            cur = _mm256_i32gather_epi32(base, _mm256_add_epi32(_mm256_slli_epi32(cur, 2), bit), 4);
+            if (_mm256_testz_si256(cur, cur)) break;
+            __m256i key = _mm256_i32gather_epi32(base, _mm256_add_epi32(_mm256_slli_epi32(cur, 2), key_off), 4);
+            best = _mm256_blendv_epi8(key, best, _mm256_cmpeq_epi32(key, zero));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), best);
+    }
+    for (; i < n; ++i) out[i] = lpm_flat(nodes, ips[i]);
+}
+#endif
+
 struct PrefixRec {
     uint32_t net;
     uint8_t len;
@@ -119,16 +311,42 @@ struct PrefixRec {
 int main(int argc, char* argv[]) {
     // Simple flag: -chk -> output real hex keys for correctness checking
     bool write_hex = false;
+    bool coro = false;
+    bool simd = false;
+    size_t coro_width = CORO_WIDTH;
+    int threads = 0;
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
         if (a == "-chk" || a == "--chk") write_hex = true;
+        else if (a == "-coro" || a == "--coro") {
+            coro = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                coro_width = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (a == "-simd" || a == "--simd") simd = true;
+        else if ((a == "-threads" || a == "--threads") && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
         else if (a == "-h" || a == "--help") {
             std::cout <<
-                "Usage: " << argv[0] << " [-chk]\n"
-                "  -chk   Write hex keys to benchmarks/match_radix.csv (slower)\n";
+                "Usage: " << argv[0] << " [-chk] [-coro [N] | -simd]\n"
+                "  -chk       Write hex keys to benchmarks/match_radix.csv (slower)\n"
+                "  -coro [N]  Coroutine-interleaved lookups, N in flight (default "
+                << CORO_WIDTH << "; needs -std=c++20)\n"
+                "  -simd      AVX2 lockstep walk of 8 addresses over a flattened node array\n"
+                "  --threads N  Also measure scalar lpm() scaling on N pinned threads\n"
+                "               (appends to benchmarks/results_threads.csv)\n";
             return 0;
         }
     }
+    if (coro && simd) {
+        std::cerr << "Error: -coro and -simd are mutually exclusive\n";
+        return 1;
+    }
+#if !defined(__cpp_impl_coroutine)
+    if (coro) {
+        std::cerr << "Error: -coro requires a C++20 build (g++ -std=c++20)\n";
+        return 1;
+    }
+#endif
 
     // Baseline memory
     size_t rss_baseline = current_rss_bytes();
@@ -177,6 +395,11 @@ int main(int argc, char* argv[]) {
     for (auto& rec : prefixes) {
         trie.insert_move(rec.net, rec.len, std::move(rec.key));
     }
+    // The flat copy is part of the lookup structure in -simd mode, so it is
+    // built (and measured) here.
+    std::vector<FlatNode> flat_nodes;
+    std::vector<const std::vector<uint8_t>*> flat_keys;
+    if (simd) trie.export_flat(flat_nodes, flat_keys);
     double build_ds_s = secs_since(tB0);
     size_t rssB1 = current_rss_bytes();
     size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
@@ -219,8 +442,27 @@ int main(int argc, char* argv[]) {
     std::vector<std::pair<std::string,std::string>> results;
     results.reserve(ips.size());
 
+    std::vector<const std::vector<uint8_t>*> keys;
+    bool simd_avx2 = false;
+    if (simd) {
+        std::vector<uint32_t> ids(ips.size());
+        auto walk = lpm_flat_batch;
+#ifdef HAVE_X86_KERNELS
+        if (__builtin_cpu_supports("avx2")) { walk = lpm_lockstep_avx2; simd_avx2 = true; }
+#endif
+        walk(flat_nodes.data(), ips.data(), ips.size(), ids.data());
+        keys.resize(ips.size());
+        for (size_t i = 0; i < ips.size(); ++i) keys[i] = flat_keys[ids[i]];
+    }
+#if defined(__cpp_impl_coroutine)
+    if (coro) {
+        keys.resize(ips.size());
+        trie.lpm_interleaved(ips.data(), ips.size(), coro_width, keys.data());
+    }
+#endif
+
     for (size_t i = 0; i < ips.size(); ++i) {
-        const auto* key = trie.lpm(ips[i]);
+        const auto* key = (coro || simd) ? keys[i] : trie.lpm(ips[i]);
         if (write_hex) {
             results.emplace_back(ip_strs[i], key ? bytes_to_hex(*key) : std::string("-1"));
         } else {
@@ -250,7 +492,9 @@ int main(int argc, char* argv[]) {
     double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
     double mem_total_mb        = bytes_to_mb(rss_total_bytes);
 
-    const char* algo_name = "BinaryRadixTrie";
+    std::string algo_name = "BinaryRadixTrie";
+    if (coro) algo_name += "-CORO" + std::to_string(coro_width);
+    if (simd) algo_name += simd_avx2 ? "-SIMD8" : "-FLAT";
     bool need_header = !file_exists(RESULTS_FILE);
 
     std::ofstream res(RESULTS_FILE, std::ios::app);
@@ -285,5 +529,11 @@ int main(int argc, char* argv[]) {
             << "\n";
     }
 
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    // Uses the plain lpm() walk whatever the -coro/-simd mode.
+    if (threads > 0)
+        mt::run_threads_benchmark("BinaryRadixTrie", ips, threads,
+                                  [&](uint32_t ip) { return trie.lpm(ip) != nullptr; });
+
     return 0;
 }
@@ -0,0 +1,402 @@
+// src/bloom_lpm.cpp
+// Per-prefix-length Bloom filter LPM (Dharmapurikar, Krishnamurthy, Taylor,
+// "Longest Prefix Matching using Bloom Filters").
+//
+// Every populated prefix length has a small Bloom filter and an exact hash
+// table. A lookup first queries all filters at once: with AVX2, eight lengths
+// per pass (masking, hashing, gather and bit test are all vector ops). It then
+// probes the exact tables only for the lengths that passed, longest first, so
+// most lookups cost a single off-filter access.
+//
+// Build with -mavx2 (or -march=native) for the vector path; otherwise the
+// filters are probed by a scalar loop.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>   // memcpy
+#include <cmath>     // log, round
+#include "mt_lookup.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// ---------------- Paths ----------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_bloom_lpm.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_bloom_lpm.csv";
+
+// ---------------- Utils ----------------
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t){ return std::chrono::duration<double>(now()-t).count(); }
+
+static inline size_t rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size(); i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
+    std::ostringstream oss;
+    for(int i=0;i<len;++i) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(key[i]);
+    return oss.str();
+}
+
+// 32-bit finalizer (murmur3 fmix32); only 32-bit multiplies so it vectorizes
+static inline uint32_t mix32(uint32_t x){
+    x ^= x >> 16; x *= 0x85ebca6bU;
+    x ^= x >> 13; x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+static inline size_t next_pow2(size_t v){
+    if(v <= 1) return 1;
+    v--; v|=v>>1; v|=v>>2; v|=v>>4; v|=v>>8; v|=v>>16;
+    if(sizeof(size_t) >= 8) v|=v>>32;
+    return v+1;
+}
+
+// ---------------- Key pool (dedup, id-indexed) ----------------
+// key id 0 is reserved for "no match"
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t*> g_keys(1, nullptr);
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
+    std::vector<uint8_t> tmp = hex_to_bytes(hex);
+    if(tmp.size() != 64) return 0;
+    uint8_t* p = new uint8_t[64];
+    std::memcpy(p, tmp.data(), 64);
+    uint32_t id = uint32_t(g_keys.size());
+    g_keys.push_back(p);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ---------------- Exact per-length table ----------------
+// Slot = (masked address << 32) | key id; all-ones marks an empty slot.
+struct LenTable {
+    static constexpr uint64_t EMPTY = ~0ULL;
+    std::vector<uint64_t> slots;
+    uint32_t mask = 0;
+
+    void init(size_t n_items){
+        size_t cap = next_pow2(std::max<size_t>(8, n_items * 2));   // load <= 0.5
+        slots.assign(cap, EMPTY);
+        mask = uint32_t(cap - 1);
+    }
+    void put(uint32_t addr, uint32_t id){
+        uint32_t i = mix32(addr) & mask;
+        while(slots[i] != EMPTY && uint32_t(slots[i] >> 32) != addr) i = (i + 1) & mask;
+        slots[i] = (uint64_t(addr) << 32) | id;
+    }
+    inline uint32_t get(uint32_t addr) const {
+        uint32_t i = mix32(addr) & mask;
+        for(;;){
+            uint64_t s = slots[i];
+            if(s == EMPTY) return 0;
+            if(uint32_t(s >> 32) == addr) return uint32_t(s);
+            i = (i + 1) & mask;
+        }
+    }
+};
+
+// ---------------- Bloom filters, one per length ----------------
+// All filters share one word array so a single gather can read any of them.
+// Lanes are grouped by 8; padding lanes have bit_mask 0 and are ignored.
+static const uint32_t SEED1 = 0x9e3779b9U;
+static const uint32_t SEED2 = 0x7f4a7c15U;
+
+struct PRec{ uint32_t base; uint8_t len; uint32_t key_id; };
+
+struct BloomLpm {
+    int k = 7;
+    double bits_per_elem = 10.0;
+    std::vector<uint8_t>  lens;        // populated lengths, ascending; lane i = lens[i]
+    std::vector<uint32_t> net_mask;    // per lane: mask_from_len
+    std::vector<uint32_t> salt;        // per lane: decorrelates lengths
+    std::vector<uint32_t> word_off;    // per lane: first word in `words`
+    std::vector<uint32_t> bit_mask;    // per lane: m_bits - 1 (0 = padding lane)
+    std::vector<uint32_t> words;       // all filter bits
+    std::vector<LenTable> tables;      // per lane: exact table
+    size_t n_groups = 0;
+
+    static inline uint32_t h1(uint32_t x, uint32_t s){ return mix32(x ^ s ^ SEED1); }
+    static inline uint32_t h2(uint32_t x, uint32_t s){ return mix32(x ^ s ^ SEED2) | 1u; }
+
+    void build(const std::vector<PRec>& pfx, double bpe){
+        bits_per_elem = bpe;
+        k = std::max(1, std::min(16, int(std::round(bpe * std::log(2.0)))));
+
+        std::unordered_map<uint32_t, uint32_t> real[33];
+        for(const auto& p : pfx) real[p.len][p.base] = p.key_id;   // duplicates keep the last key
+        for(int l=0;l<=32;++l) if(!real[l].empty()) lens.push_back(uint8_t(l));
+
+        n_groups = (lens.size() + 7) / 8;
+        size_t lanes = n_groups * 8;
+        net_mask.assign(lanes, 0); salt.assign(lanes, 0);
+        word_off.assign(lanes, 0); bit_mask.assign(lanes, 0);
+        tables.resize(lens.size());
+
+        size_t total_words = 0;
+        for(size_t i=0;i<lens.size();++i){
+            size_t n = real[lens[i]].size();
+            size_t m_bits = next_pow2(std::max<size_t>(256, size_t(std::ceil(bpe * double(n)))));
+            net_mask[i] = mask_from_len(lens[i]);
+            salt[i]     = uint32_t(lens[i]) * 0x85ebca77U;
+            word_off[i] = uint32_t(total_words);
+            bit_mask[i] = uint32_t(m_bits - 1);
+            total_words += m_bits / 32;
+        }
+        words.assign(total_words, 0);
+
+        for(size_t i=0;i<lens.size();++i){
+            tables[i].init(real[lens[i]].size());
+            for(const auto& kv : real[lens[i]]){
+                tables[i].put(kv.first, kv.second);
+                uint32_t a = h1(kv.first, salt[i]), b = h2(kv.first, salt[i]);
+                for(int j=0;j<k;++j){
+                    uint32_t bit = (a + uint32_t(j) * b) & bit_mask[i];
+                    words[word_off[i] + (bit >> 5)] |= 1u << (bit & 31);
+                }
+            }
+        }
+    }
+
+    // Bit i set -> length lens[i] possibly holds a prefix of ip.
+    inline uint64_t candidates(uint32_t ip) const {
+        uint64_t cand = 0;
+#ifdef __AVX2__
+        const __m256i vip   = _mm256_set1_epi32(int(ip));
+        const __m256i one   = _mm256_set1_epi32(1);
+        const __m256i c1    = _mm256_set1_epi32(int(0x85ebca6bU));
+        const __m256i c2    = _mm256_set1_epi32(int(0xc2b2ae35U));
+        const __m256i s1    = _mm256_set1_epi32(int(SEED1));
+        const __m256i s2    = _mm256_set1_epi32(int(SEED2));
+        const __m256i m31   = _mm256_set1_epi32(31);
+        auto vmix = [&](__m256i x){
+            x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16)); x = _mm256_mullo_epi32(x, c1);
+            x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 13)); x = _mm256_mullo_epi32(x, c2);
+            return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+        };
+        for(size_t g=0; g<n_groups; ++g){
+            const __m256i vmask = _mm256_loadu_si256((const __m256i*)&net_mask[g*8]);
+            const __m256i vsalt = _mm256_loadu_si256((const __m256i*)&salt[g*8]);
+            const __m256i voff  = _mm256_loadu_si256((const __m256i*)&word_off[g*8]);
+            const __m256i vbits = _mm256_loadu_si256((const __m256i*)&bit_mask[g*8]);
+            __m256i x = _mm256_xor_si256(_mm256_and_si256(vip, vmask), vsalt);
+            __m256i a = vmix(_mm256_xor_si256(x, s1));
+            __m256i b = _mm256_or_si256(vmix(_mm256_xor_si256(x, s2)), one);
+            __m256i ok = _mm256_cmpgt_epi32(vbits, _mm256_setzero_si256()); // live lanes
+            for(int j=0;j<k;++j){
+                __m256i bit  = _mm256_and_si256(a, vbits);
+                __m256i widx = _mm256_add_epi32(voff, _mm256_srli_epi32(bit, 5));
+                __m256i w    = _mm256_i32gather_epi32((const int*)words.data(), widx, 4);
+                __m256i t    = _mm256_and_si256(_mm256_srlv_epi32(w, _mm256_and_si256(bit, m31)), one);
+                ok = _mm256_and_si256(ok, _mm256_cmpeq_epi32(t, one));
+                a  = _mm256_add_epi32(a, b);
+            }
+            cand |= uint64_t(uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(ok)))) << (g*8);
+        }
+#else
+        for(size_t i=0;i<lens.size();++i){
+            uint32_t x = ip & net_mask[i];
+            uint32_t a = h1(x, salt[i]), b = h2(x, salt[i]);
+            bool hit = true;
+            for(int j=0;j<k && hit;++j){
+                uint32_t bit = (a + uint32_t(j) * b) & bit_mask[i];
+                hit = (words[word_off[i] + (bit >> 5)] >> (bit & 31)) & 1u;
+            }
+            if(hit) cand |= 1ULL << i;
+        }
+#endif
+        return cand;
+    }
+
+    // probes counts exact-table accesses (for the false-positive cost)
+    inline uint32_t lookup(uint32_t ip, uint64_t& probes) const {
+        uint64_t cand = candidates(ip);
+        while(cand){
+            int i = 63 - __builtin_clzll(cand);      // longest remaining length
+            ++probes;
+            uint32_t id = tables[i].get(ip & net_mask[i]);
+            if(id) return id;
+            cand &= ~(1ULL << i);
+        }
+        return 0;
+    }
+
+    size_t bloom_bytes() const { return words.size() * sizeof(uint32_t); }
+    size_t table_bytes() const {
+        size_t b = 0;
+        for(const auto& t : tables) b += t.slots.size() * sizeof(uint64_t);
+        return b;
+    }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    int threads = 0;
+    double bits_per_elem = 10.0;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if((a=="-b"||a=="--bits") && i+1<argc) bits_per_elem = std::stod(argv[++i]);
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-b bits_per_elem] [--threads N]\n"
+                       "  -b   Bloom filter bits per prefix (default 10)\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+    if(bits_per_elem <= 0.0){ std::cerr<<"Error: bits_per_elem must be > 0\n"; return 1; }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0=now(); size_t rA0=rss_bytes();
+
+    std::vector<PRec> prefixes; prefixes.reserve(200000);
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf, line); // header "prefix,key"
+
+    size_t num_prefixes=0;
+    while(std::getline(pf, line)){
+        std::istringstream ss(line);
+        std::string pfx, khex;
+        if(!std::getline(ss, pfx, ',')) continue;
+        if(!std::getline(ss, khex)) continue;
+
+        auto slash = pfx.find('/');
+        if(slash == std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0, slash));
+        uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
+
+        prefixes.push_back({net, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    double mem_prefix_mb = to_mb(rss_bytes() - rA0);
+
+    // -------- Phase B: Build filters + exact tables --------
+    auto tB0=now(); size_t rB0=rss_bytes();
+
+    BloomLpm bl;
+    bl.build(prefixes, bits_per_elem);
+
+    double build_ds_s = secs_since(tB0);
+    double mem_ds_mb  = to_mb(rss_bytes() - rB0);
+
+    prefixes.clear(); prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rC0=rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header "ip,used_prefix"
+
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    std::vector<uint32_t>    ips;     ips.reserve(1<<20);
+
+    while(std::getline(ipf, line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss, ip_s, ',')) continue;
+        std::getline(ss, dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    double mem_ip_mb = to_mb(rss_bytes() - rC0);
+
+    // -------- Phase D: Lookup (filters first, then exact tables) --------
+    auto tD0=now();
+
+    uint64_t table_probes = 0;
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint8_t* key = g_keys[bl.lookup(ips[i], table_probes)];
+        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
+    }
+
+    double lookup_s = secs_since(tD0);
+    double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+    double probes_per_lookup = ips.empty()? 0.0 : double(table_probes) / double(ips.size());
+
+    // -------- Write match file --------
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r : results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // -------- Metrics CSV (MB) --------
+    double mem_total_mb = to_mb(rss_bytes());
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "bf_bits_per_elem,k,num_lengths,mem_bloom_mb,mem_tables_mb,table_probes_per_lookup\n";
+    }
+#ifdef __AVX2__
+    const char* algo_name = "BloomLPM-AVX2";
+#else
+    const char* algo_name = "BloomLPM";
+#endif
+    res<<algo_name<<','
+       <<PREFIX_FILE<<','<<IP_FILE<<','
+       <<num_prefixes<<','<<ips.size()<<','
+       <<std::fixed<<std::setprecision(6)
+       <<prefix_load_s<<','<<build_ds_s<<','<<ip_load_s<<','<<lookup_s<<','
+       <<std::setprecision(2)
+       <<lookups_per_s<<','<<ns_per_lookup<<','
+       <<std::setprecision(2)
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
+       <<bits_per_elem<<','<<bl.k<<','<<bl.lens.size()<<','
+       <<std::setprecision(4)
+       <<to_mb(bl.bloom_bytes())<<','<<to_mb(bl.table_bytes())<<','<<probes_per_lookup<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark(algo_name, ips, threads, [&](uint32_t ip){ uint64_t probes=0; return bl.lookup(ip, probes)!=0; });
+
+    // -------- Cleanup (keys) --------
+    for(auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
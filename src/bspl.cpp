@@ -0,0 +1,324 @@
+// src/bspl.cpp
+// Binary search on prefix lengths (Waldvogel et al., "Scalable High Speed IP
+// Routing Lookups").
+//
+// One open-addressing hash table per populated prefix length. A lookup does a
+// binary search over the sorted lengths: a hit moves to longer lengths, a miss
+// to shorter ones. Markers are inserted at every shorter length on a prefix's
+// search path so the search is steered toward it, and every entry (prefix or
+// marker) stores its precomputed best matching prefix, so the last hit is the
+// answer. That is O(log W) probes per lookup, with W = number of lengths.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include "mt_lookup.h"
+
+// ---------------- Paths ----------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_bspl.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_bspl.csv";
+
+// ---------------- Utils ----------------
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t){ return std::chrono::duration<double>(now()-t).count(); }
+
+static inline size_t rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size(); i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
+    std::ostringstream oss;
+    for(int i=0;i<len;++i) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(key[i]);
+    return oss.str();
+}
+
+// 32-bit finalizer (murmur3 fmix32)
+static inline uint32_t mix32(uint32_t x){
+    x ^= x >> 16; x *= 0x85ebca6bU;
+    x ^= x >> 13; x *= 0xc2b2ae35U;
+    x ^= x >> 16;
+    return x;
+}
+static inline size_t next_pow2(size_t v){
+    if(v <= 1) return 1;
+    v--; v|=v>>1; v|=v>>2; v|=v>>4; v|=v>>8; v|=v>>16;
+    if(sizeof(size_t) >= 8) v|=v>>32;
+    return v+1;
+}
+
+// ---------------- Key pool (dedup, id-indexed) ----------------
+// key id 0 is reserved for "no match"
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t*> g_keys(1, nullptr);
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
+    std::vector<uint8_t> tmp = hex_to_bytes(hex);
+    if(tmp.size() != 64) return 0;
+    uint8_t* p = new uint8_t[64];
+    std::memcpy(p, tmp.data(), 64);
+    uint32_t id = uint32_t(g_keys.size());
+    g_keys.push_back(p);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ---------------- Per-length hash table ----------------
+// Slot = (masked address << 32) | bmp key id; all-ones marks an empty slot.
+struct LenTable {
+    static constexpr uint64_t EMPTY = ~0ULL;
+    std::vector<uint64_t> slots;
+    uint32_t mask = 0;
+
+    void init(size_t n_items){
+        size_t cap = next_pow2(std::max<size_t>(8, n_items * 2));   // load <= 0.5
+        slots.assign(cap, EMPTY);
+        mask = uint32_t(cap - 1);
+    }
+    void put(uint32_t addr, uint32_t bmp){
+        uint32_t i = mix32(addr) & mask;
+        while(slots[i] != EMPTY && uint32_t(slots[i] >> 32) != addr) i = (i + 1) & mask;
+        slots[i] = (uint64_t(addr) << 32) | bmp;
+    }
+    // true if present; bmp receives the stored key id
+    inline bool get(uint32_t addr, uint32_t& bmp) const {
+        uint32_t i = mix32(addr) & mask;
+        for(;;){
+            uint64_t s = slots[i];
+            if(s == EMPTY) return false;
+            if(uint32_t(s >> 32) == addr){ bmp = uint32_t(s); return true; }
+            i = (i + 1) & mask;
+        }
+    }
+};
+
+struct PRec{ uint32_t base; uint8_t len; uint32_t key_id; };
+
+struct Bspl {
+    std::vector<uint8_t>  lens;      // populated lengths, ascending
+    std::vector<uint32_t> masks;     // mask_from_len(lens[i])
+    std::vector<LenTable> tables;    // one per populated length
+    size_t num_markers = 0;
+
+    void build(const std::vector<PRec>& pfx){
+        // real prefixes per length; duplicates keep the last key
+        std::unordered_map<uint32_t, uint32_t> real[33];
+        for(const auto& p : pfx) real[p.len][p.base] = p.key_id;
+        for(int l=0;l<=32;++l) if(!real[l].empty()) lens.push_back(uint8_t(l));
+        for(uint8_t l : lens) masks.push_back(mask_from_len(l));
+
+        auto bmp_of = [&](uint32_t addr, int upto){
+            for(int l=upto; l>=0; --l){
+                if(real[l].empty()) continue;
+                auto it = real[l].find(addr & mask_from_len(uint8_t(l)));
+                if(it != real[l].end()) return it->second;
+            }
+            return 0u;
+        };
+
+        // entries[i]: address -> bmp for lens[i]; markers on each search path
+        std::vector<std::unordered_map<uint32_t, uint32_t>> entries(lens.size());
+        for(size_t i=0;i<lens.size();++i)
+            for(const auto& kv : real[lens[i]]) entries[i][kv.first] = kv.second;
+
+        for(size_t t=0;t<lens.size();++t){
+            for(const auto& kv : real[lens[t]]){
+                int lo = 0, hi = int(lens.size()) - 1;
+                while(lo <= hi){
+                    int mid = (lo + hi) / 2;
+                    if(size_t(mid) == t) break;
+                    if(size_t(mid) > t){ hi = mid - 1; continue; }
+                    uint32_t marker = kv.first & masks[mid];
+                    if(!entries[mid].count(marker)){
+                        entries[mid][marker] = bmp_of(marker, lens[mid]);
+                        ++num_markers;
+                    }
+                    lo = mid + 1;
+                }
+            }
+        }
+
+        tables.resize(lens.size());
+        for(size_t i=0;i<lens.size();++i){
+            tables[i].init(entries[i].size());
+            for(const auto& kv : entries[i]) tables[i].put(kv.first, kv.second);
+        }
+    }
+
+    inline uint32_t lookup(uint32_t ip) const {
+        uint32_t best = 0;
+        int lo = 0, hi = int(lens.size()) - 1;
+        while(lo <= hi){
+            int mid = (lo + hi) >> 1;
+            uint32_t bmp;
+            if(tables[mid].get(ip & masks[mid], bmp)){ best = bmp; lo = mid + 1; }
+            else hi = mid - 1;
+        }
+        return best;
+    }
+
+    size_t bytes() const {
+        size_t b = 0;
+        for(const auto& t : tables) b += t.slots.size() * sizeof(uint64_t);
+        return b;
+    }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    int threads = 0;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [--threads N]\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0=now(); size_t rA0=rss_bytes();
+
+    std::vector<PRec> prefixes; prefixes.reserve(200000);
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf, line); // header "prefix,key"
+
+    size_t num_prefixes=0;
+    while(std::getline(pf, line)){
+        std::istringstream ss(line);
+        std::string pfx, khex;
+        if(!std::getline(ss, pfx, ',')) continue;
+        if(!std::getline(ss, khex)) continue;
+
+        auto slash = pfx.find('/');
+        if(slash == std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0, slash));
+        uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
+
+        prefixes.push_back({net, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    double mem_prefix_mb = to_mb(rss_bytes() - rA0);
+
+    // -------- Phase B: Build per-length tables + markers --------
+    auto tB0=now(); size_t rB0=rss_bytes();
+
+    Bspl bspl;
+    bspl.build(prefixes);
+
+    double build_ds_s = secs_since(tB0);
+    double mem_ds_mb  = to_mb(rss_bytes() - rB0);
+
+    prefixes.clear(); prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rC0=rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header "ip,used_prefix"
+
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    std::vector<uint32_t>    ips;     ips.reserve(1<<20);
+
+    while(std::getline(ipf, line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss, ip_s, ',')) continue;
+        std::getline(ss, dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    double mem_ip_mb = to_mb(rss_bytes() - rC0);
+
+    // -------- Phase D: Lookup --------
+    auto tD0=now();
+
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint8_t* key = g_keys[bspl.lookup(ips[i])];
+        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
+    }
+
+    double lookup_s = secs_since(tD0);
+    double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write match file --------
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r : results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // -------- Metrics CSV (MB) --------
+    double mem_total_mb = to_mb(rss_bytes());
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "num_lengths,num_markers,bspl_struct_mb\n";
+    }
+    res<<"BSPL-Waldvogel"<<','
+       <<PREFIX_FILE<<','<<IP_FILE<<','
+       <<num_prefixes<<','<<ips.size()<<','
+       <<std::fixed<<std::setprecision(6)
+       <<prefix_load_s<<','<<build_ds_s<<','<<ip_load_s<<','<<lookup_s<<','
+       <<std::setprecision(2)
+       <<lookups_per_s<<','<<ns_per_lookup<<','
+       <<std::setprecision(2)
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
+       <<bspl.lens.size()<<','<<bspl.num_markers<<','
+       <<std::setprecision(4)<<to_mb(bspl.bytes())<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark("BSPL-Waldvogel", ips, threads, [&](uint32_t ip){ return bspl.lookup(ip)!=0; });
+
+    // -------- Cleanup (keys) --------
+    for(auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
@@ -12,10 +12,13 @@
 #include <unordered_set>
 #include <algorithm>
 #include <unistd.h>   // sysconf
+#include <cstdlib>    // aligned_alloc
+#include "mt_lookup.h"
 
 // ------------------------- Config / constants -------------------------
 static const int MAIN_TABLE_SIZE = 1 << 24;  // 2^24
 static const int SUBTABLE_SIZE   = 256;
+static const size_t BATCH_GROUP  = 16;       // addresses in flight per lookup_batch stage
 
 // File paths (relative to repo root)
 static const char* PREFIX_FILE   = "data/prefix_table.csv";
@@ -96,17 +99,165 @@ uint8_t* get_or_create_key(const std::string& hex) {
     return bytes;
 }
 
+// ------------------------- Key-ID mode -------------------------------
+// Table slots hold a 16- or 32-bit index into one contiguous, 64-byte aligned
+// key array instead of an 8-byte key pointer (id 0 = no key).
+uint8_t* g_key_array = nullptr;   // (num_keys + 1) x 64 bytes
+size_t   g_num_keys  = 0;
+
+// Copies every pooled key into g_key_array; returns key pointer -> id.
+std::unordered_map<const uint8_t*, uint32_t> build_key_array() {
+    std::unordered_map<const uint8_t*, uint32_t> ids;
+    g_num_keys = g_key_pool.size();
+    g_key_array = static_cast<uint8_t*>(std::aligned_alloc(64, (g_num_keys + 1) * 64));
+    std::memset(g_key_array, 0, 64);
+    uint32_t id = 0;
+    for (const auto& kv : g_key_pool) {
+        ++id;
+        std::memcpy(g_key_array + size_t(id) * 64, kv.second, 64);
+        ids.emplace(kv.second, id);
+    }
+    return ids;
+}
+
+// Number of distinct /24s that hold a longer prefix, i.e. TBLlong blocks.
+size_t count_long_blocks(const std::vector<PrefixRec>& prefixes) {
+    std::unordered_set<uint32_t> blocks;
+    for (const auto& rec : prefixes) {
+        if (rec.len <= 24 || rec.len > 32 || !rec.key) continue;
+        blocks.insert(rec.base_ip >> 8);
+    }
+    return blocks.size();
+}
+
+// Key-ID tables in the tagged layout of dir_24_8_tagged.cpp: main_table slots
+// hold either a key id or, with the top bit (FLAG) set, the index of a
+// 256-entry block in one contiguous pool. A block carries the <= /24 match of
+// its slot in every entry no longer prefix covers, so a lookup is one load,
+// or two for addresses under a /25../32. Id is uint16_t only when every key id
+// and block index fits in 15 bits.
+template <typename Id>
+struct Dir24KeyIds {
+    static constexpr Id FLAG = Id(Id(1) << (sizeof(Id) * 8 - 1));
+    Id*             main_table = nullptr;   // [2^24] -> key id, or FLAG | block
+    std::vector<Id> pool;                   // blocks x 256 key ids (for > /24)
+
+    void build(const std::vector<PrefixRec>& prefixes,
+               const std::unordered_map<const uint8_t*, uint32_t>& ids) {
+        main_table = new Id[MAIN_TABLE_SIZE]();
+        // Same first-wins fill as the pointer tables; block slots are only
+        // tagged at the end, once every <= /24 match is known.
+        std::unordered_map<uint32_t, uint32_t> block_of;   // main_idx -> block
+        for (const auto& rec : prefixes) {
+            if (rec.len > 32 || !rec.key) continue;
+            const Id id = static_cast<Id>(ids.at(rec.key));
+            if (rec.len <= 24) {
+                const uint32_t start = rec.base_ip >> 8;
+                const uint32_t fill  = 1u << (24 - rec.len);
+                for (uint32_t i = 0; i < fill; ++i) {
+                    if (!main_table[start + i]) main_table[start + i] = id;
+                }
+            } else {
+                const uint32_t main_idx = rec.base_ip >> 8;
+                auto it = block_of.find(main_idx);
+                if (it == block_of.end()) {
+                    it = block_of.emplace(main_idx, uint32_t(pool.size() / SUBTABLE_SIZE)).first;
+                    pool.resize(pool.size() + SUBTABLE_SIZE, 0);
+                }
+                Id* block = pool.data() + size_t(it->second) * SUBTABLE_SIZE;
+                const uint32_t low   = rec.base_ip & 0xFF;
+                const uint32_t count = 1u << (32 - rec.len);
+                for (uint32_t off = 0; off < count; ++off) {
+                    if (!block[low + off]) block[low + off] = id;
+                }
+            }
+        }
+        for (const auto& kv : block_of) {
+            Id* block = pool.data() + size_t(kv.second) * SUBTABLE_SIZE;
+            const Id fallback = main_table[kv.first];
+            for (int i = 0; i < SUBTABLE_SIZE; ++i) {
+                if (!block[i]) block[i] = fallback;
+            }
+            main_table[kv.first] = Id(FLAG | kv.second);
+        }
+        pool.shrink_to_fit();
+    }
+
+    inline uint32_t lookup_id(uint32_t ip) const {
+        Id e = main_table[ip >> 8];
+        if (e & FLAG) e = pool[size_t(e & ~FLAG) * SUBTABLE_SIZE + (ip & 0xFF)];
+        return e;
+    }
+
+    inline const uint8_t* lookup(uint32_t ip) const {
+        const uint32_t id = lookup_id(ip);
+        return id ? g_key_array + size_t(id) * 64 : nullptr;
+    }
+
+    // Group-prefetched lookup: for each group of BATCH_GROUP addresses, first
+    // prefetch every main-table slot, then prefetch the pool entries of the
+    // slots that point to a block, then resolve. Overlaps the DRAM misses of
+    // the whole group.
+    void lookup_batch(const uint32_t* ips, size_t n, uint32_t* out_key_ids) const {
+        Id e[BATCH_GROUP];
+        for (size_t base = 0; base < n; base += BATCH_GROUP) {
+            const size_t m = std::min(BATCH_GROUP, n - base);
+            const uint32_t* ip = ips + base;
+            for (size_t j = 0; j < m; ++j) __builtin_prefetch(&main_table[ip[j] >> 8]);
+            for (size_t j = 0; j < m; ++j) {
+                e[j] = main_table[ip[j] >> 8];
+                if (e[j] & FLAG) __builtin_prefetch(&pool[size_t(e[j] & ~FLAG) * SUBTABLE_SIZE + (ip[j] & 0xFF)]);
+            }
+            for (size_t j = 0; j < m; ++j) {
+                if (e[j] & FLAG) e[j] = pool[size_t(e[j] & ~FLAG) * SUBTABLE_SIZE + (ip[j] & 0xFF)];
+                out_key_ids[base + j] = e[j];
+            }
+        }
+    }
+
+    size_t blocks() const { return pool.size() / SUBTABLE_SIZE; }
+
+    ~Dir24KeyIds() { delete[] main_table; }
+};
+
+// Runs key_of over every IP and records "1"/"-1" or the hex key.
+template <typename F>
+void lookup_all(const std::vector<uint32_t>& ips, bool write_hex,
+                std::vector<std::string>& results, F key_of) {
+    for (uint32_t ip : ips) {
+        const uint8_t* key = key_of(ip);
+        if (write_hex) {
+            results.emplace_back(key ? bytes_to_hex(key) : "-1");
+        } else {
+            results.emplace_back(key ? "1" : "-1");
+        }
+    }
+}
+
 // ------------------------- Main --------------------------------------
 int main(int argc, char* argv[]) {
     // Check for -chk flag to output hex keys
     bool write_hex = false;
+    bool key_ids   = false;
+    bool batch     = false;
+    int  threads   = 0;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         if (arg == "-chk" || arg == "--chk") {
             write_hex = true;
+        } else if (arg == "-ids" || arg == "--ids") {
+            key_ids = true;
+        } else if (arg == "-batch" || arg == "--batch") {
+            batch = key_ids = true;   // lookup_batch returns key ids
+        } else if ((arg == "-threads" || arg == "--threads") && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
         } else if (arg == "-h" || arg == "--help") {
-            std::cout << "Usage: " << argv[0] << " [-chk]\n"
-                      << "  -chk   Write hex keys to match file (slower)\n";
+            std::cout << "Usage: " << argv[0] << " [-chk] [-ids] [-batch] [--threads N]\n"
+                      << "  -chk   Write hex keys to match file (slower)\n"
+                      << "  -ids   Key-ID mode: 16/32-bit key indices instead of key pointers\n"
+                      << "  -batch Key-ID mode with group-prefetched lookup_batch\n"
+                      << "  --threads N  Also measure per-address lookup scaling on N pinned\n"
+                      << "               threads (appends to benchmarks/results_threads.csv)\n";
             return 0;
         }
     }
@@ -157,37 +308,48 @@ int main(int argc, char* argv[]) {
     auto tB0 = now();
     size_t rssB0 = current_rss_bytes();
 
-    // allocate top-level tables
-    main_table = new uint8_t*[MAIN_TABLE_SIZE]();
-    sub_tables = new uint8_t**[MAIN_TABLE_SIZE]();
-
-    // Fill tables from prefixes
-    for (const auto& rec : prefixes) {
-        const uint32_t ip_aligned = rec.base_ip;
-        const uint8_t len = rec.len;
-        if (len > 32) continue;  // Skip invalid prefix lengths
-        uint8_t* key = rec.key;
-
-        if (len <= 24) {
-            const uint32_t start = ip_aligned >> 8;
-            const uint32_t fill  = 1u << (24 - len);
-            for (uint32_t i = 0; i < fill; ++i) {
-                if (!main_table[start + i]) {
-                    main_table[start + i] = key;
-                }
-            }
-        } else {
-            const uint32_t count = 1u << (32 - len);
-            for (uint32_t off = 0; off < count; ++off) {
-                uint32_t ip_full  = ip_aligned + off;
-                uint32_t main_idx = ip_full >> 8;
-                uint8_t  sub_idx  = static_cast<uint8_t>(ip_full & 0xFF);
-
-                if (!sub_tables[main_idx]) {
-                    sub_tables[main_idx] = new uint8_t*[SUBTABLE_SIZE]();
+    Dir24KeyIds<uint16_t> ids16;
+    Dir24KeyIds<uint32_t> ids32;
+    int id_bits = 0;   // 0 = pointer tables
+    if (key_ids) {
+        auto ids = build_key_array();
+        // 16-bit slots spend their top bit on the block tag
+        id_bits = (g_num_keys < 0x8000 && count_long_blocks(prefixes) < 0x8000) ? 16 : 32;
+        if (id_bits == 16) ids16.build(prefixes, ids);
+        else               ids32.build(prefixes, ids);
+    } else {
+        // allocate top-level tables
+        main_table = new uint8_t*[MAIN_TABLE_SIZE]();
+        sub_tables = new uint8_t**[MAIN_TABLE_SIZE]();
+
+        // Fill tables from prefixes
+        for (const auto& rec : prefixes) {
+            const uint32_t ip_aligned = rec.base_ip;
+            const uint8_t len = rec.len;
+            if (len > 32) continue;  // Skip invalid prefix lengths
+            uint8_t* key = rec.key;
+
+            if (len <= 24) {
+                const uint32_t start = ip_aligned >> 8;
+                const uint32_t fill  = 1u << (24 - len);
+                for (uint32_t i = 0; i < fill; ++i) {
+                    if (!main_table[start + i]) {
+                        main_table[start + i] = key;
+                    }
                 }
-                if (!sub_tables[main_idx][sub_idx]) {
-                    sub_tables[main_idx][sub_idx] = key;
+            } else {
+                const uint32_t count = 1u << (32 - len);
+                for (uint32_t off = 0; off < count; ++off) {
+                    uint32_t ip_full  = ip_aligned + off;
+                    uint32_t main_idx = ip_full >> 8;
+                    uint8_t  sub_idx  = static_cast<uint8_t>(ip_full & 0xFF);
+
+                    if (!sub_tables[main_idx]) {
+                        sub_tables[main_idx] = new uint8_t*[SUBTABLE_SIZE]();
+                    }
+                    if (!sub_tables[main_idx][sub_idx]) {
+                        sub_tables[main_idx][sub_idx] = key;
+                    }
                 }
             }
         }
@@ -236,21 +398,28 @@ int main(int argc, char* argv[]) {
     std::vector<std::string> results;
     results.reserve(ips.size());
 
-    for (uint32_t ip : ips) {
-        uint32_t main_idx = ip >> 8;
-        uint8_t  sub_idx  = static_cast<uint8_t>(ip & 0xFF);
-
-        uint8_t* key = nullptr;
-        if (sub_tables[main_idx] && sub_tables[main_idx][sub_idx]) {
-            key = sub_tables[main_idx][sub_idx];
-        } else if (main_table[main_idx]) {
-            key = main_table[main_idx];
-        }
-        if (write_hex) {
-            results.emplace_back(key ? bytes_to_hex(key) : "-1");
-        } else {
-            results.emplace_back(key ? "1" : "-1");
-        }
+    if (batch) {
+        std::vector<uint32_t> out(ips.size());
+        if (id_bits == 16) ids16.lookup_batch(ips.data(), ips.size(), out.data());
+        else               ids32.lookup_batch(ips.data(), ips.size(), out.data());
+        size_t i = 0;
+        lookup_all(ips, write_hex, results, [&](uint32_t) -> const uint8_t* {
+            const uint32_t id = out[i++];
+            return id ? g_key_array + size_t(id) * 64 : nullptr;
+        });
+    } else if (id_bits == 16) {
+        lookup_all(ips, write_hex, results, [&](uint32_t ip) { return ids16.lookup(ip); });
+    } else if (id_bits == 32) {
+        lookup_all(ips, write_hex, results, [&](uint32_t ip) { return ids32.lookup(ip); });
+    } else {
+        lookup_all(ips, write_hex, results, [&](uint32_t ip) -> const uint8_t* {
+            uint32_t main_idx = ip >> 8;
+            uint8_t  sub_idx  = static_cast<uint8_t>(ip & 0xFF);
+            if (sub_tables[main_idx] && sub_tables[main_idx][sub_idx]) {
+                return sub_tables[main_idx][sub_idx];
+            }
+            return main_table[main_idx];
+        });
     }
 
     double lookup_time_s = seconds_since(tD0);
@@ -284,7 +453,9 @@ int main(int argc, char* argv[]) {
     // algorithm,prefix_file,ip_file,num_prefixes,num_ips,
     // prefix_load_s,build_ds_s,ip_load_s,lookup_s,lookups_per_s,ns_per_lookup,
     // mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb
-    const char* algo_name = "DIR-24-8";
+    // (key-ID mode reports as DIR-24-8-ID16 / DIR-24-8-ID32, plus -BATCH)
+    std::string algo_name = id_bits ? "DIR-24-8-ID" + std::to_string(id_bits) : "DIR-24-8";
+    if (batch) algo_name += "-BATCH";
 
     bool write_header = !file_exists(RESULTS_FILE);
     std::ofstream r(RESULTS_FILE, std::ios::app);
@@ -318,6 +489,27 @@ int main(int argc, char* argv[]) {
           << "\n";
     }
 
+    // ----------------- Optional: multithreaded scaling run ---------
+    // Per-address lookups in the selected table layout (-batch runs as its
+    // key-ID layout, since the driver hands out one address at a time).
+    if (threads > 0) {
+        std::string mt_name = id_bits ? "DIR-24-8-ID" + std::to_string(id_bits) : "DIR-24-8";
+        if (id_bits == 16) {
+            mt::run_threads_benchmark(mt_name, ips, threads,
+                                      [&](uint32_t ip) { return ids16.lookup(ip) != nullptr; });
+        } else if (id_bits == 32) {
+            mt::run_threads_benchmark(mt_name, ips, threads,
+                                      [&](uint32_t ip) { return ids32.lookup(ip) != nullptr; });
+        } else {
+            mt::run_threads_benchmark(mt_name, ips, threads, [&](uint32_t ip) {
+                uint32_t main_idx = ip >> 8;
+                uint8_t  sub_idx  = static_cast<uint8_t>(ip & 0xFF);
+                if (sub_tables[main_idx] && sub_tables[main_idx][sub_idx]) return true;
+                return main_table[main_idx] != nullptr;
+            });
+        }
+    }
+
     // ----------------- Cleanup -------------------------------------
     for (auto& kv : g_key_pool) delete[] kv.second;
     g_key_pool.clear();
@@ -329,6 +521,7 @@ int main(int argc, char* argv[]) {
         delete[] sub_tables;
     }
     if (main_table) delete[] main_table;
+    std::free(g_key_array);
 
     return 0;
 }
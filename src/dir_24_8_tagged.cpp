@@ -0,0 +1,596 @@
+// DIR-24-8 in the original Gupta-McKeown layout: one TBL24 of tagged 32-bit
+// entries plus a contiguous TBLlong pool of 256-entry blocks. Prefixes of
+// length <= 24 resolve with a single memory access. With -hash, /25../32
+// prefixes go to an exact-match hash table instead of TBLlong (hybrid mode).
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <unistd.h>   // sysconf
+#include <cstdlib>    // aligned_alloc
+#include "mt_lookup.h"
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // AVX2 / AVX-512 kernels (compiled via target attributes)
+#define HAVE_X86_KERNELS 1
+#endif
+
+// ------------------------- Config / constants -------------------------
+static const int      TBL24_SIZE = 1 << 24;       // 2^24
+static const int      BLOCK_SIZE = 256;           // TBLlong block (one per /24)
+static const uint32_t LONG_FLAG  = 0x80000000u;   // entry -> TBLlong block index
+
+// File paths (relative to repo root)
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_dir24_8_tagged.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_dir24_8_tagged.csv";
+
+// ------------------------- Memory / timing helpers --------------------
+size_t current_rss_bytes() {
+    // Linux: /proc/self/statm (resident pages * page size)
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+inline auto now() {
+    return std::chrono::high_resolution_clock::now();
+}
+inline double seconds_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+inline double bytes_to_mb(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// ------------------------- Utilities ---------------------------------
+uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+std::string bytes_to_hex(const uint8_t* key, int len = 64) {
+    std::ostringstream oss;
+    for (int i = 0; i < len; ++i) {
+        oss << std::hex << std::setw(2) << std::setfill('0')
+            << static_cast<int>(key[i]);
+    }
+    return oss.str();
+}
+bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+
+// ------------------------- Key handling -------------------------------
+// Keys are deduplicated into ids 1..N (0 = no key); after loading they are
+// packed into one 64-byte aligned array so an id maps to one cache line.
+std::unordered_map<std::string, uint32_t> g_key_ids;
+std::vector<uint8_t> g_key_bytes;     // 64 bytes per id, filled while loading
+uint8_t* g_key_array = nullptr;       // (num_keys + 1) x 64 bytes, aligned
+
+uint32_t get_or_create_key_id(const std::string& hex) {
+    if (hex.size() != 128) return 0;
+    auto it = g_key_ids.find(hex);
+    if (it != g_key_ids.end()) return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(g_key_ids.size()) + 1;
+    for (size_t i = 0; i < 128; i += 2) {
+        g_key_bytes.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+void build_key_array() {
+    const size_t num_keys = g_key_ids.size();
+    g_key_array = static_cast<uint8_t*>(std::aligned_alloc(64, (num_keys + 1) * 64));
+    std::memset(g_key_array, 0, 64);
+    if (num_keys) std::memcpy(g_key_array + 64, g_key_bytes.data(), num_keys * 64);
+    g_key_bytes.clear();
+    g_key_bytes.shrink_to_fit();
+}
+
+// ------------------------- Data structures ---------------------------
+struct PrefixRec {
+    uint32_t base_ip;  // aligned network address
+    uint8_t  len;      // prefix length
+    uint32_t key_id;   // index into g_key_array (0 = none)
+};
+
+// TBL24 entry: LONG_FLAG clear -> key id (0 = no match)
+//              LONG_FLAG set   -> index of a 256-entry block in TBLlong
+uint32_t*             tbl24 = nullptr;   // [2^24]
+std::vector<uint32_t> tbllong;           // blocks of 256 key ids
+
+// Prefixes are applied shortest first, so a longer prefix simply overwrites
+// the entries it covers. All <= /24 prefixes are written before any TBLlong
+// block exists; a new block inherits the /24 entry it replaces.
+void build_tables(std::vector<PrefixRec>& prefixes) {
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const PrefixRec& a, const PrefixRec& b) { return a.len < b.len; });
+
+    tbl24 = new uint32_t[TBL24_SIZE]();
+    for (const auto& rec : prefixes) {
+        if (rec.len > 32 || !rec.key_id) continue;
+
+        if (rec.len <= 24) {
+            const uint32_t start = rec.base_ip >> 8;
+            const uint32_t fill  = 1u << (24 - rec.len);
+            std::fill(tbl24 + start, tbl24 + start + fill, rec.key_id);
+        } else {
+            const uint32_t idx = rec.base_ip >> 8;
+            if (!(tbl24[idx] & LONG_FLAG)) {
+                const uint32_t block = static_cast<uint32_t>(tbllong.size() / BLOCK_SIZE);
+                tbllong.resize(tbllong.size() + BLOCK_SIZE, tbl24[idx]);
+                tbl24[idx] = LONG_FLAG | block;
+            }
+            const size_t   base  = static_cast<size_t>(tbl24[idx] & ~LONG_FLAG) * BLOCK_SIZE;
+            const uint32_t first = rec.base_ip & 0xFF;
+            const uint32_t count = 1u << (32 - rec.len);
+            std::fill(tbllong.begin() + base + first, tbllong.begin() + base + first + count, rec.key_id);
+        }
+    }
+    tbllong.shrink_to_fit();
+}
+
+// One access for <= /24 matches, a second (well-predicted) one for longer.
+inline uint32_t lookup_id(uint32_t ip) {
+    uint32_t e = tbl24[ip >> 8];
+    if (e & LONG_FLAG) {
+        e = tbllong[(static_cast<size_t>(e & ~LONG_FLAG) << 8) | (ip & 0xFF)];
+    }
+    return e;
+}
+
+// ------------------------- Lookup kernels ----------------------------
+// A kernel resolves n addresses into key ids. The SIMD kernels shift 8/16
+// addresses at once, gather their TBL24 entries, and do a second masked
+// gather from TBLlong only for lanes whose entry has LONG_FLAG set. They are
+// compiled with target attributes, so a plain -O2 build contains all three
+// and pick_kernel() chooses at run time (cpuid via __builtin_cpu_supports).
+typedef void (*LookupKernel)(const uint32_t* ips, size_t n, uint32_t* out_key_ids);
+
+void lookup_scalar(const uint32_t* ips, size_t n, uint32_t* out_key_ids) {
+    for (size_t i = 0; i < n; ++i) out_key_ids[i] = lookup_id(ips[i]);
+}
+
+#ifdef HAVE_X86_KERNELS
+// Gather indexes are signed 32-bit: fine for 2^24 TBL24 slots and for
+// TBLlong up to 2^23 blocks (8 GB).
+__attribute__((target("avx2")))
+void lookup_avx2(const uint32_t* ips, size_t n, uint32_t* out_key_ids) {
+    const int*    t24   = reinterpret_cast<const int*>(tbl24);
+    const int*    tlong = reinterpret_cast<const int*>(tbllong.data());
+    const __m256i flag  = _mm256_set1_epi32(static_cast<int>(LONG_FLAG));
+    const __m256i low8  = _mm256_set1_epi32(0xFF);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i ip   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ips + i));
+        __m256i e    = _mm256_i32gather_epi32(t24, _mm256_srli_epi32(ip, 8), 4);
+        __m256i lng  = _mm256_cmpeq_epi32(_mm256_and_si256(e, flag), flag);
+        if (!_mm256_testz_si256(lng, lng)) {
+            __m256i idx = _mm256_or_si256(_mm256_slli_epi32(_mm256_andnot_si256(flag, e), 8),
+                                          _mm256_and_si256(ip, low8));
+            e = _mm256_mask_i32gather_epi32(e, tlong, idx, lng, 4);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out_key_ids + i), e);
+    }
+    for (; i < n; ++i) out_key_ids[i] = lookup_id(ips[i]);
+}
+
+__attribute__((target("avx512f")))
+void lookup_avx512(const uint32_t* ips, size_t n, uint32_t* out_key_ids) {
+    const int*    t24   = reinterpret_cast<const int*>(tbl24);
+    const int*    tlong = reinterpret_cast<const int*>(tbllong.data());
+    const __m512i flag  = _mm512_set1_epi32(static_cast<int>(LONG_FLAG));
+    const __m512i low8  = _mm512_set1_epi32(0xFF);
+    // GCC's unmasked 512-bit shifts/andnot/gather pass an undefined register
+    // through and trip -Wmaybe-uninitialized; the all-lanes masked forms with
+    // a zero source compile to the same instructions.
+    const __m512i   zero = _mm512_setzero_si512();
+    const __mmask16 all  = 0xFFFF;
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m512i   ip  = _mm512_loadu_si512(ips + i);
+        __m512i   hi  = _mm512_maskz_srli_epi32(all, ip, 8);
+        __m512i   e   = _mm512_mask_i32gather_epi32(zero, all, hi, t24, 4);
+        __mmask16 lng = _mm512_test_epi32_mask(e, flag);
+        if (lng) {
+            __m512i blk = _mm512_maskz_andnot_epi32(all, flag, e);
+            __m512i idx = _mm512_or_si512(_mm512_maskz_slli_epi32(all, blk, 8),
+                                          _mm512_and_si512(ip, low8));
+            e = _mm512_mask_i32gather_epi32(e, lng, idx, tlong, 4);
+        }
+        _mm512_storeu_si512(out_key_ids + i, e);
+    }
+    for (; i < n; ++i) out_key_ids[i] = lookup_id(ips[i]);
+}
+#endif
+
+// want: "auto", "scalar", "avx2" or "avx512". Falls back to the best
+// supported kernel if the requested one is unavailable on this CPU.
+LookupKernel pick_kernel(const std::string& want, std::string& name) {
+#ifdef HAVE_X86_KERNELS
+    const bool has512 = __builtin_cpu_supports("avx512f");
+    const bool has2   = __builtin_cpu_supports("avx2");
+    if ((want == "auto" || want == "avx512") && has512) { name = "avx512"; return lookup_avx512; }
+    if (want != "scalar" && has2)                        { name = "avx2";   return lookup_avx2; }
+#endif
+    (void)want;
+    name = "scalar";
+    return lookup_scalar;
+}
+
+// ------------------------- Hybrid mode (-hash) -----------------------
+// TBL24 entry with LONG_FLAG set = "check the long table"; the low bits keep
+// the <= /24 key id as fallback. /25../32 prefixes live in LongHash keyed by
+// (length, network), probed longest length first.
+//
+// LongHash is a SwissTable-style open-addressing table: 16 control bytes per
+// group (0x80 = empty, else the low 7 hash bits), compared against the probe
+// tag with one SSE2 instruction; keys and values sit in parallel arrays.
+struct LongHash {
+    static constexpr int     GROUP = 16;
+    static constexpr uint8_t EMPTY = 0x80;
+
+    std::vector<uint8_t>  ctrl;   // [num_groups * 16]
+    std::vector<uint64_t> keys;   // (len << 32) | network
+    std::vector<uint32_t> vals;   // key id
+    size_t group_mask = 0;
+    size_t size = 0;
+
+    static inline uint64_t make_key(uint32_t net, uint8_t len) {
+        return (static_cast<uint64_t>(len) << 32) | net;
+    }
+    static inline uint64_t hash(uint64_t x) {
+        x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+        return x ^ (x >> 33);
+    }
+    // Bit i set when control byte i of group g equals tag.
+    inline uint32_t match(size_t g, uint8_t tag) const {
+#ifdef __SSE2__
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&ctrl[g * GROUP]));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8(static_cast<char>(tag)))));
+#else
+        uint32_t m = 0;
+        for (int i = 0; i < GROUP; ++i) m |= static_cast<uint32_t>(ctrl[g * GROUP + i] == tag) << i;
+        return m;
+#endif
+    }
+
+    void init(size_t n) {
+        size_t groups = 1;
+        while (groups * GROUP * 7 < n * 8) groups <<= 1;   // load factor <= 7/8
+        ctrl.assign(groups * GROUP, EMPTY);
+        keys.assign(groups * GROUP, 0);
+        vals.assign(groups * GROUP, 0);
+        group_mask = groups - 1;
+    }
+
+    void insert(uint64_t key, uint32_t val) {   // overwrites: last duplicate wins
+        const uint64_t h = hash(key);
+        const uint8_t tag = static_cast<uint8_t>(h & 0x7F);
+        for (size_t g = (h >> 7) & group_mask;; g = (g + 1) & group_mask) {
+            for (uint32_t m = match(g, tag); m; m &= m - 1) {
+                size_t slot = g * GROUP + __builtin_ctz(m);
+                if (keys[slot] == key) { vals[slot] = val; return; }
+            }
+            uint32_t empty = match(g, EMPTY);
+            if (empty) {
+                size_t slot = g * GROUP + __builtin_ctz(empty);
+                ctrl[slot] = tag; keys[slot] = key; vals[slot] = val;
+                ++size;
+                return;
+            }
+        }
+    }
+
+    inline uint32_t find(uint64_t key) const {
+        const uint64_t h = hash(key);
+        const uint8_t tag = static_cast<uint8_t>(h & 0x7F);
+        for (size_t g = (h >> 7) & group_mask;; g = (g + 1) & group_mask) {
+            for (uint32_t m = match(g, tag); m; m &= m - 1) {
+                size_t slot = g * GROUP + __builtin_ctz(m);
+                if (keys[slot] == key) return vals[slot];
+            }
+            if (match(g, EMPTY)) return 0;
+        }
+    }
+
+    size_t bytes() const {
+        return ctrl.size() + keys.size() * sizeof(uint64_t) + vals.size() * sizeof(uint32_t);
+    }
+};
+
+LongHash long_hash;
+uint32_t long_len_mask = 0;   // bit (len - 25) set when some /len (25..32) exists
+
+void build_tables_hybrid(std::vector<PrefixRec>& prefixes) {
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const PrefixRec& a, const PrefixRec& b) { return a.len < b.len; });
+
+    size_t num_long = 0;
+    for (const auto& rec : prefixes) num_long += (rec.len > 24 && rec.len <= 32 && rec.key_id);
+    long_hash.init(num_long);
+
+    tbl24 = new uint32_t[TBL24_SIZE]();
+    for (const auto& rec : prefixes) {
+        if (rec.len > 32 || !rec.key_id) continue;
+
+        if (rec.len <= 24) {
+            const uint32_t start = rec.base_ip >> 8;
+            const uint32_t fill  = 1u << (24 - rec.len);
+            std::fill(tbl24 + start, tbl24 + start + fill, rec.key_id);
+        } else {
+            tbl24[rec.base_ip >> 8] |= LONG_FLAG;
+            long_hash.insert(LongHash::make_key(rec.base_ip, rec.len), rec.key_id);
+            long_len_mask |= 1u << (rec.len - 25);
+        }
+    }
+}
+
+inline uint32_t lookup_id_hybrid(uint32_t ip) {
+    const uint32_t e = tbl24[ip >> 8];
+    if (!(e & LONG_FLAG)) return e;
+    for (uint32_t m = long_len_mask; m; ) {
+        const int bit = 31 - __builtin_clz(m);   // longest remaining length
+        const uint8_t len = static_cast<uint8_t>(25 + bit);
+        const uint32_t id = long_hash.find(LongHash::make_key(ip & mask_from_len(len), len));
+        if (id) return id;
+        m &= ~(1u << bit);
+    }
+    return e & ~LONG_FLAG;
+}
+
+// Runs lookup over every IP and records "1"/"-1" or the hex key.
+template <typename F>
+void lookup_all(const std::vector<uint32_t>& ips, bool write_hex,
+                std::vector<std::string>& results, F lookup) {
+    for (uint32_t ip : ips) {
+        const uint32_t id = lookup(ip);
+        if (write_hex) {
+            results.emplace_back(id ? bytes_to_hex(g_key_array + static_cast<size_t>(id) * 64) : "-1");
+        } else {
+            results.emplace_back(id ? "1" : "-1");
+        }
+    }
+}
+
+// ------------------------- Main --------------------------------------
+int main(int argc, char* argv[]) {
+    // Check for -chk flag to output hex keys
+    bool write_hex = false;
+    bool hybrid    = false;
+    std::string kernel_req = "auto";
+    int  threads   = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-chk" || arg == "--chk") {
+            write_hex = true;
+        } else if (arg == "-hash" || arg == "--hash") {
+            hybrid = true;
+        } else if ((arg == "-k" || arg == "--kernel") && i + 1 < argc) {
+            kernel_req = argv[++i];
+            if (kernel_req != "auto" && kernel_req != "scalar" &&
+                kernel_req != "avx2" && kernel_req != "avx512") {
+                std::cerr << "Error: unknown kernel '" << kernel_req << "'\n";
+                return 1;
+            }
+        } else if ((arg == "-threads" || arg == "--threads") && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [-chk] [-hash] [-k auto|scalar|avx2|avx512] [--threads N]\n"
+                      << "  -chk   Write hex keys to match file (slower)\n"
+                      << "  -hash  Hybrid mode: /25../32 in an exact-match hash table instead of TBLlong\n"
+                      << "  -k     Lookup kernel for the TBLlong layout (default auto = best the CPU supports)\n"
+                      << "  --threads N  Also measure scalar lookup scaling on N pinned threads\n"
+                      << "               (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // ----------------- Phase A: Load Prefixes (batch) -----------------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream fib(PREFIX_FILE);
+    std::string line;
+    std::getline(fib, line); // skip header "prefix,key"
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000); // guess; adjust as needed
+
+    size_t num_prefixes = 0;
+    while (std::getline(fib, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',')) continue;
+        if (!std::getline(ss, key_hex)) continue;
+
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        uint32_t base_ip = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        prefixes.push_back({base_ip, len, get_or_create_key_id(key_hex)});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = seconds_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // ----------------- Phase B: Build DS (TBL24 + TBLlong) ------------
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+
+    build_key_array();
+    if (hybrid) build_tables_hybrid(prefixes);
+    else        build_tables(prefixes);
+
+    double build_ds_s = seconds_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+
+    // Optional: free prefix array to observe DS-only memory
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    // ----------------- Phase C: Load IPs (batch) ----------------------
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipfile(IP_FILE);
+    std::getline(ipfile, line); // skip header "ip,used_prefix"
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1000000); ip_strs.reserve(1000000); // guess; adjust as needed
+
+    while (std::getline(ipfile, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, discard;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, discard); // used_prefix (ignored for speed)
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = seconds_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // ----------------- Phase D: Lookup -------------------------------
+    auto tD0 = now();
+
+    std::vector<std::string> results;
+    results.reserve(ips.size());
+
+    // The hybrid layout has no TBLlong to gather from and always runs scalar.
+    std::string kernel_name = "scalar";
+    if (hybrid) {
+        lookup_all(ips, write_hex, results, lookup_id_hybrid);
+    } else {
+        LookupKernel kernel = pick_kernel(kernel_req, kernel_name);
+        std::vector<uint32_t> ids(ips.size());
+        kernel(ips.data(), ips.size(), ids.data());
+        size_t i = 0;
+        lookup_all(ips, write_hex, results, [&](uint32_t) { return ids[i++]; });
+    }
+
+    double lookup_time_s = seconds_since(tD0);
+    double ns_per_lookup = (ips.empty() ? 0.0 : (lookup_time_s * 1e9 / static_cast<double>(ips.size())));
+    double lookups_per_s = (lookup_time_s > 0.0 ? (static_cast<double>(ips.size()) / lookup_time_s) : 0.0);
+
+    // ----------------- Output matches -------------------------------
+    {
+        std::ofstream out(MATCH_FILE);
+        if (!out.is_open()) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (size_t i = 0; i < ips.size(); ++i) {
+                out << ip_strs[i] << "," << results[i] << "\n";
+            }
+        }
+    }
+
+    // ----------------- Final memory totals --------------------------
+    size_t rss_total_bytes = current_rss_bytes();
+
+    // Convert memory to MB for output
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(rss_total_bytes);
+    size_t tbllong_blocks      = tbllong.size() / BLOCK_SIZE;
+    double tbllong_mb          = bytes_to_mb(tbllong.size() * sizeof(uint32_t));
+    double hash_mb             = bytes_to_mb(long_hash.bytes());
+
+    // ----------------- Append metrics CSV ---------------------------
+    // Columns:
+    // algorithm,prefix_file,ip_file,num_prefixes,num_ips,
+    // prefix_load_s,build_ds_s,ip_load_s,lookup_s,lookups_per_s,ns_per_lookup,
+    // mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,
+    // tbllong_blocks,tbllong_mb,hash_entries,hash_mb,kernel
+    const char* algo_name = hybrid ? "DIR-24-8-HASH" : "DIR-24-8-TBL24";
+
+    bool write_header = !file_exists(RESULTS_FILE);
+    std::ofstream r(RESULTS_FILE, std::ios::app);
+    if (!r.is_open()) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        r.setf(std::ios::fixed);
+        if (write_header) {
+            r << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                 "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                 "lookups_per_s,ns_per_lookup,"
+                 "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+                 "tbllong_blocks,tbllong_mb,hash_entries,hash_mb,kernel\n";
+        }
+        r << algo_name << ","
+          << PREFIX_FILE << ","
+          << IP_FILE << ","
+          << num_prefixes << ","
+          << ips.size() << ","
+          << std::setprecision(6)
+          << prefix_load_s << ","
+          << build_ds_s << ","
+          << ip_load_s << ","
+          << lookup_time_s << ","
+          << std::setprecision(2) << lookups_per_s << ","
+          << std::setprecision(2) << ns_per_lookup << ","
+          << std::setprecision(2)
+          << mem_prefix_array_mb << ","
+          << mem_ds_mb << ","
+          << mem_ip_array_mb << ","
+          << mem_total_mb << ","
+          << tbllong_blocks << ","
+          << tbllong_mb << ","
+          << long_hash.size << ","
+          << hash_mb << ","
+          << kernel_name
+          << "\n";
+    }
+
+    // ----------------- Optional: multithreaded scaling run ---------
+    // Per-address scalar lookups; the SIMD kernels work on whole batches.
+    if (threads > 0) {
+        if (hybrid) mt::run_threads_benchmark(algo_name, ips, threads, lookup_id_hybrid);
+        else        mt::run_threads_benchmark(algo_name, ips, threads, lookup_id);
+    }
+
+    // ----------------- Cleanup -------------------------------------
+    delete[] tbl24;
+    std::free(g_key_array);
+
+    return 0;
+}
@@ -1,4 +1,14 @@
-// src/dxr_16_8_8.cpp
+// src/dxr.cpp
+// DXR-style DIR-16-8-8 lookup over one flat, tagged entry pool.
+//
+// L1 is indexed by the top 16 address bits; /17../24 and /25../32 prefixes
+// live in 256-entry L2/L3 blocks appended to the same array. An entry with the
+// top bit set is a block index, otherwise a key id (0 = no match), so a lookup
+// is 1-3 dependent loads and the table has no pointers. Entries shrink to 16
+// bits when every key id and block index fits in 15.
+//
+// results_dxr.csv carries two extra columns: entry_bits (16/32) and
+// num_blocks (L2+L3 blocks in the pool).
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -11,6 +21,9 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include "mt_lookup.h"
 // ---------------- Paths ----------------
 static const char* PREFIX_FILE   = "data/prefix_table.csv";
 static const char* IP_FILE       = "data/generated_ips.csv";
@@ -43,40 +56,128 @@ static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
 }
 
 // ---------------- Key pool (dedup) ----------------
-static std::unordered_map<std::string, uint8_t*> g_key_pool;
-
-static inline uint8_t* get_or_create_key(const std::string& hex){
-    auto it = g_key_pool.find(hex);
-    if(it != g_key_pool.end()) return it->second;
+// Keys get ids 1..N (0 = no key) and are packed into one 64-byte aligned array.
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t> g_key_bytes;      // 64 bytes per id while loading
+static uint8_t* g_key_array = nullptr;        // (num_keys+1) x 64 bytes
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
     // expect 128 hex chars (64 bytes)
     std::vector<uint8_t> tmp = hex_to_bytes(hex);
-    if(tmp.size() != 64) return nullptr;
-    uint8_t* p = new uint8_t[64];
-    std::memcpy(p, tmp.data(), 64);
-    g_key_pool.emplace(hex, p);
-    return p;
+    if(tmp.size() != 64) return 0;
+    g_key_bytes.insert(g_key_bytes.end(), tmp.begin(), tmp.end());
+    uint32_t id = uint32_t(g_key_ids.size()) + 1;
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+static void build_key_array(){
+    size_t n = g_key_ids.size();
+    g_key_array = static_cast<uint8_t*>(std::aligned_alloc(64, (n+1)*64));
+    std::memset(g_key_array, 0, 64);
+    if(n) std::memcpy(g_key_array + 64, g_key_bytes.data(), n*64);
+    g_key_bytes.clear(); g_key_bytes.shrink_to_fit();
 }
 
-// ---------------- DXR (DIR-16-8-8) ----------------
-// Level 1: 2^16 entries of fallback keys for /0..16
-// Level 2: per-/16 allocation of 256-entry arrays of keys for /17..24
-// Level 3: per-/24 allocation of 256-entry arrays of keys for /25..32
+// ---------------- DXR (DIR-16-8-8), flat ----------------
+// All levels live in one pool of entries: L1 is the first 2^16 entries, and
+// every L2 (/17../24) and L3 (/25../32) table is a 256-entry block appended
+// after it. An entry with BLOCK_FLAG set holds the index of the next-level
+// block; otherwise it holds a key id (0 = no match). Shorter matches are
+// pushed down into the blocks, so a lookup is 1-3 loads from one array.
 static const int L1_SIZE = 1 << 16;
-static const int L2_SIZE = 256;
-static const int L3_SIZE = 256;
+static const int BLOCK   = 256;
+static const uint32_t BLOCK_FLAG = 0x80000000u;
+static const size_t BATCH_GROUP = 16;   // addresses in flight per lookup_batch stage
+
+struct PRec{ uint32_t base; uint8_t len; uint32_t key_id; };
+
+static std::vector<uint32_t> build_pool(std::vector<PRec>& prefixes){
+    // shortest first: longer prefixes overwrite, last duplicate wins
+    std::stable_sort(prefixes.begin(), prefixes.end(), [](const PRec& a, const PRec& b){ return a.len < b.len; });
+    std::vector<uint32_t> pool(L1_SIZE, 0);
+    auto child = [&](size_t slot) -> size_t {   // block behind slot, created on demand
+        if(!(pool[slot] & BLOCK_FLAG)){
+            uint32_t blk = uint32_t(pool.size() / BLOCK), inherit = pool[slot];
+            pool.resize(pool.size() + BLOCK, inherit);
+            pool[slot] = BLOCK_FLAG | blk;
+        }
+        return size_t(pool[slot] & ~BLOCK_FLAG) * BLOCK;
+    };
+    for(const auto& rec : prefixes){
+        uint32_t net = rec.base; uint8_t len = rec.len;
+        if(len > 32 || !rec.key_id) continue;  // Skip invalid prefix lengths
+        uint32_t top = net >> 16, mid = (net >> 8) & 0xFFu, low = net & 0xFFu;
+        // ascending lengths: a range being filled never contains block entries yet
+        if(len <= 16){
+            std::fill(pool.begin() + top, pool.begin() + top + (1u << (16 - len)), rec.key_id);
+        } else if(len <= 24){
+            size_t b2 = child(top);
+            std::fill(pool.begin() + b2 + mid, pool.begin() + b2 + mid + (1u << (24 - len)), rec.key_id);
+        } else {
+            size_t b3 = child(child(top) + mid);
+            std::fill(pool.begin() + b3 + low, pool.begin() + b3 + low + (1u << (32 - len)), rec.key_id);
+        }
+    }
+    return pool;
+}
 
-uint8_t**   L1_keys   = nullptr;          // [2^16] -> key*
-uint8_t***  L2_tables = nullptr;          // [2^16] -> (uint8_t*[256]) or nullptr
-uint8_t**** L3_tables = nullptr;          // [2^16] -> (uint8_t**[256]) or nullptr
-                                          // where L3_tables[top][mid] -> uint8_t*[256] or nullptr
+// Entry type E is uint16_t when every key id and block index fits in 15 bits.
+template<typename E>
+struct FlatDxr {
+    static constexpr E FLAG = E(E(1) << (sizeof(E)*8 - 1));
+    std::vector<E> pool;
+
+    void assign(const std::vector<uint32_t>& p){
+        pool.resize(p.size());
+        for(size_t i=0;i<p.size();++i) pool[i] = (p[i] & BLOCK_FLAG) ? E(FLAG | (p[i] & ~BLOCK_FLAG)) : E(p[i]);
+    }
+    inline uint32_t lookup(uint32_t ip) const {
+        E e = pool[ip >> 16];
+        if(e & FLAG) e = pool[size_t(e & ~FLAG) * BLOCK + ((ip >> 8) & 0xFFu)];
+        if(e & FLAG) e = pool[size_t(e & ~FLAG) * BLOCK + (ip & 0xFFu)];
+        return e;
+    }
+    // Group-prefetched lookup: one stage per level over BATCH_GROUP addresses;
+    // each stage loads the entries prefetched by the previous one and
+    // prefetches the next-level slot for the lanes that still point to a block.
+    void lookup_batch(const uint32_t* ips, size_t n, uint32_t* out_key_ids) const {
+        E e[BATCH_GROUP];
+        for(size_t base=0; base<n; base+=BATCH_GROUP){
+            const size_t m = std::min(BATCH_GROUP, n - base);
+            const uint32_t* ip = ips + base;
+            for(size_t j=0;j<m;++j) __builtin_prefetch(&pool[ip[j] >> 16]);
+            for(size_t j=0;j<m;++j){
+                e[j] = pool[ip[j] >> 16];
+                if(e[j] & FLAG) __builtin_prefetch(&pool[size_t(e[j] & ~FLAG) * BLOCK + ((ip[j] >> 8) & 0xFFu)]);
+            }
+            for(size_t j=0;j<m;++j){
+                if(!(e[j] & FLAG)) continue;
+                e[j] = pool[size_t(e[j] & ~FLAG) * BLOCK + ((ip[j] >> 8) & 0xFFu)];
+                if(e[j] & FLAG) __builtin_prefetch(&pool[size_t(e[j] & ~FLAG) * BLOCK + (ip[j] & 0xFFu)]);
+            }
+            for(size_t j=0;j<m;++j){
+                if(e[j] & FLAG) e[j] = pool[size_t(e[j] & ~FLAG) * BLOCK + (ip[j] & 0xFFu)];
+                out_key_ids[base + j] = e[j];
+            }
+        }
+    }
+};
 
 int main(int argc, char* argv[]){
     bool write_hex = false;
+    bool batch     = false;
+    int  threads   = 0;
     for(int i=1;i<argc;++i){
         std::string a = argv[i];
         if(a=="-chk"||a=="--chk") write_hex = true;
+        else if(a=="-batch"||a=="--batch") batch = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
         else if(a=="-h"||a=="--help"){
-            std::cout<<"Usage: "<<argv[0]<<" [-chk]\n";
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-batch] [--threads N]\n"
+                     <<"  -batch  group-prefetched lookup_batch instead of one lookup at a time\n"
+                     <<"  --threads N  also measure per-address lookup scaling on N pinned threads (results_threads.csv)\n";
             return 0;
         }
     }
@@ -85,7 +186,6 @@ int main(int argc, char* argv[]){
     if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
     auto tA0=now(); size_t rA0=rss_bytes();
 
-    struct PRec{ uint32_t base; uint8_t len; uint8_t* key; };
     std::vector<PRec> prefixes; prefixes.reserve(200000);
 
     std::ifstream pf(PREFIX_FILE);
@@ -104,10 +204,10 @@ int main(int argc, char* argv[]){
         uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
         net &= mask_from_len(len);
 
-        uint8_t* key = get_or_create_key(khex);
-        if(!key) continue;
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
 
-        prefixes.push_back({net, len, key});
+        prefixes.push_back({net, len, key_id});
         ++num_prefixes;
     }
 
@@ -117,60 +217,22 @@ int main(int argc, char* argv[]){
     // -------- Phase B: Build DXR structure --------
     auto tB0=now(); size_t rB0=rss_bytes();
 
-    // allocate top-level
-    L1_keys   = new uint8_t*[L1_SIZE]();    // zeroed
-    L2_tables = new uint8_t**[L1_SIZE]();   // nullptrs
-    L3_tables = new uint8_t***[L1_SIZE]();  // nullptrs
-
-    auto ensure_L2 = [&](uint32_t top){
-        if(!L2_tables[top]) L2_tables[top] = new uint8_t*[L2_SIZE]();
-    };
-    auto ensure_L3_mid = [&](uint32_t top, uint32_t mid){
-        if(!L3_tables[top]) L3_tables[top] = new uint8_t**[L2_SIZE]();
-        if(!L3_tables[top][mid]) L3_tables[top][mid] = new uint8_t*[L3_SIZE]();
-    };
-
-    for(const auto& rec : prefixes){
-        uint32_t net = rec.base;
-        uint8_t  len = rec.len;
-        if(len > 32) continue;  // Skip invalid prefix lengths
-        uint8_t* key = rec.key;
-
-        if(len <= 16){
-            uint32_t start = net >> 16;
-            uint32_t fill  = 1u << (16 - len);
-            for(uint32_t i=0;i<fill;++i){
-                uint32_t idx = start + i;
-                if(!L1_keys[idx]) L1_keys[idx] = key;  // only if empty (less-specific fallback)
-            }
-        } else if(len <= 24){
-            uint32_t top   = net >> 16;
-            uint32_t mid_s = (net >> 8) & 0xFFu;
-            uint32_t fill  = 1u << (24 - len);
-            ensure_L2(top);
-            for(uint32_t j=0;j<fill;++j){
-                uint32_t mid = mid_s + j;
-                if(!L2_tables[top][mid]) L2_tables[top][mid] = key; // set if empty
-            }
-        } else {
-            // /25..32
-            uint32_t top   = net >> 16;
-            uint32_t mid   = (net >> 8) & 0xFFu;
-            uint32_t low_s = net & 0xFFu;
-            uint32_t fill  = 1u << (32 - len);
-            ensure_L3_mid(top, mid);
-            for(uint32_t k=0;k<fill;++k){
-                uint32_t low = low_s + k;
-                if(!L3_tables[top][mid][low]) L3_tables[top][mid][low] = key; // set if empty
-            }
-        }
+    build_key_array();
+    FlatDxr<uint16_t> dxr16;
+    FlatDxr<uint32_t> dxr32;
+    size_t num_blocks = 0;
+    int entry_bits = 32;
+    {
+        std::vector<uint32_t> pool = build_pool(prefixes);
+        num_blocks = (pool.size() - L1_SIZE) / BLOCK;
+        if(g_key_ids.size() < 0x8000 && pool.size() / BLOCK < 0x8000){ entry_bits = 16; dxr16.assign(pool); }
+        else dxr32.assign(pool);
     }
 
     double build_ds_s = secs_since(tB0);
     double mem_ds_mb  = to_mb(rss_bytes() - rB0);
 
     // Optionally free the vector to isolate DS memory
-    // (keys remain owned by g_key_pool and referenced by DS)
     prefixes.clear(); prefixes.shrink_to_fit();
 
     // -------- Phase C: Load IPs (batch) --------
@@ -199,25 +261,17 @@ int main(int argc, char* argv[]){
     auto tD0=now();
 
     std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
-    for(size_t i=0;i<ips.size();++i){
-        uint32_t ip  = ips[i];
-        uint32_t top = ip >> 16;
-        uint32_t mid = (ip >> 8) & 0xFFu;
-        uint32_t low = ip & 0xFFu;
-
-        uint8_t* key = nullptr;
-        // most specific first
-        if(L3_tables[top] && L3_tables[top][mid] && L3_tables[top][mid][low]){
-            key = L3_tables[top][mid][low];
-        } else if(L2_tables[top] && L2_tables[top][mid]){
-            key = L2_tables[top][mid];
-        } else if(L1_keys[top]){
-            key = L1_keys[top];
+    std::vector<uint32_t> batch_ids(batch ? ips.size() : 0);
+    auto run_lookups = [&](const auto& dxr){
+        if(batch) dxr.lookup_batch(ips.data(), ips.size(), batch_ids.data());
+        for(size_t i=0;i<ips.size();++i){
+            uint32_t id = batch ? batch_ids[i] : dxr.lookup(ips[i]);
+            if(write_hex) results.emplace_back(ip_strs[i], id ? bytes_to_hex(g_key_array + size_t(id)*64) : std::string("-1"));
+            else          results.emplace_back(ip_strs[i], id ? std::string("1")   : std::string("-1"));
         }
-
-        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
-        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
-    }
+    };
+    if(entry_bits == 16) run_lookups(dxr16);
+    else                 run_lookups(dxr32);
 
     double lookup_s = secs_since(tD0);
     double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
@@ -238,9 +292,10 @@ int main(int argc, char* argv[]){
         res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
               "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
               "lookups_per_s,ns_per_lookup,"
-              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb\n";
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "entry_bits,num_blocks\n";
     }
-    res<<"DXR-16-8-8"<<','
+    res<<(batch ? "DXR-16-8-8-BATCH" : "DXR-16-8-8")<<','
        <<PREFIX_FILE<<','<<IP_FILE<<','
        <<num_prefixes<<','<<ips.size()<<','
        <<std::fixed<<std::setprecision(6)
@@ -248,30 +303,17 @@ int main(int argc, char* argv[]){
        <<std::setprecision(2)
        <<lookups_per_s<<','<<ns_per_lookup<<','
        <<std::setprecision(2)
-       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<'\n';
-
-    // -------- Cleanup (keys + tables) --------
-    for(auto& kv : g_key_pool) delete[] kv.second;
-    g_key_pool.clear();
-
-    if(L3_tables){
-        for(int top=0; top<L1_SIZE; ++top){
-            if(L3_tables[top]){
-                for(int mid=0; mid<L2_SIZE; ++mid){
-                    if(L3_tables[top][mid]) delete[] L3_tables[top][mid];
-                }
-                delete[] L3_tables[top];
-            }
-        }
-        delete[] L3_tables;
-    }
-    if(L2_tables){
-        for(int top=0; top<L1_SIZE; ++top){
-            if(L2_tables[top]) delete[] L2_tables[top];
-        }
-        delete[] L2_tables;
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
+       <<entry_bits<<','<<num_blocks<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N, per-address lookup) --------
+    if(threads>0){
+        if(entry_bits == 16) mt::run_threads_benchmark("DXR-16-8-8", ips, threads, [&](uint32_t ip){ return dxr16.lookup(ip)!=0; });
+        else                 mt::run_threads_benchmark("DXR-16-8-8", ips, threads, [&](uint32_t ip){ return dxr32.lookup(ip)!=0; });
     }
-    if(L1_keys) delete[] L1_keys;
+
+    // -------- Cleanup --------
+    std::free(g_key_array);
 
     return 0;
 }
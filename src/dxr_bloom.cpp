@@ -13,6 +13,14 @@
 #include <cstring>   // memcpy
 #include <cmath>     // log, ceil
 #include <limits>
+#include <cstdlib>   // aligned_alloc
+#include <algorithm>
+#include "mt_lookup.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // ---------------- Paths ----------------
 static const char* PREFIX_FILE   = "data/prefix_table.csv";
@@ -60,27 +68,74 @@ static inline size_t next_pow2(size_t v){
 }
 
 // ---------------- Key pool (dedup) ----------------
-static std::unordered_map<std::string, uint8_t*> g_key_pool;
-
-static inline uint8_t* get_or_create_key(const std::string& hex){
-    auto it = g_key_pool.find(hex);
-    if(it != g_key_pool.end()) return it->second;
+// Keys get ids 1..N (0 = no key) and are packed into one 64-byte aligned array.
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t> g_key_bytes;      // 64 bytes per id while loading
+static uint8_t* g_key_array = nullptr;        // (num_keys+1) x 64 bytes
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
     std::vector<uint8_t> tmp = hex_to_bytes(hex);
-    if(tmp.size() != 64) return nullptr;
-    uint8_t* p = new uint8_t[64];
-    std::memcpy(p, tmp.data(), 64);
-    g_key_pool.emplace(hex, p);
-    return p;
+    if(tmp.size() != 64) return 0;
+    g_key_bytes.insert(g_key_bytes.end(), tmp.begin(), tmp.end());
+    uint32_t id = uint32_t(g_key_ids.size()) + 1;
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+static void build_key_array(){
+    size_t n = g_key_ids.size();
+    g_key_array = static_cast<uint8_t*>(std::aligned_alloc(64, (n+1)*64));
+    std::memset(g_key_array, 0, 64);
+    if(n) std::memcpy(g_key_array + 64, g_key_bytes.data(), n*64);
+    g_key_bytes.clear(); g_key_bytes.shrink_to_fit();
 }
 
-// ---------------- DXR (DIR-16-8-8) ----------------
+// ---------------- DXR (DIR-16-8-8), flat ----------------
+// One pool of uint32 entries: L1 is the first 2^16 entries, every L2/L3 table
+// is a 256-entry block appended after it. BLOCK_FLAG set -> next-level block
+// index, clear -> key id (0 = no match). Shorter matches are pushed down.
 static const int L1_SIZE = 1 << 16;
-static const int L2_SIZE = 256;
-static const int L3_SIZE = 256;
+static const int BLOCK   = 256;
+static const uint32_t BLOCK_FLAG = 0x80000000u;
+
+struct PRec{ uint32_t base; uint8_t len; uint32_t key_id; };
+
+static std::vector<uint32_t> build_pool(std::vector<PRec>& prefixes){
+    // shortest first: longer prefixes overwrite, last duplicate wins
+    std::stable_sort(prefixes.begin(), prefixes.end(), [](const PRec& a, const PRec& b){ return a.len < b.len; });
+    std::vector<uint32_t> pool(L1_SIZE, 0);
+    auto child = [&](size_t slot) -> size_t {   // block behind slot, created on demand
+        if(!(pool[slot] & BLOCK_FLAG)){
+            uint32_t blk = uint32_t(pool.size() / BLOCK), inherit = pool[slot];
+            pool.resize(pool.size() + BLOCK, inherit);
+            pool[slot] = BLOCK_FLAG | blk;
+        }
+        return size_t(pool[slot] & ~BLOCK_FLAG) * BLOCK;
+    };
+    for(const auto& rec : prefixes){
+        uint32_t net = rec.base; uint8_t len = rec.len;
+        if(len > 32 || !rec.key_id) continue;  // Skip invalid prefix lengths
+        uint32_t top = net >> 16, mid = (net >> 8) & 0xFFu, low = net & 0xFFu;
+        if(len <= 16){
+            std::fill(pool.begin() + top, pool.begin() + top + (1u << (16 - len)), rec.key_id);
+        } else if(len <= 24){
+            size_t b2 = child(top);
+            std::fill(pool.begin() + b2 + mid, pool.begin() + b2 + mid + (1u << (24 - len)), rec.key_id);
+        } else {
+            size_t b3 = child(child(top) + mid);
+            std::fill(pool.begin() + b3 + low, pool.begin() + b3 + low + (1u << (32 - len)), rec.key_id);
+        }
+    }
+    return pool;
+}
 
-uint8_t**   L1_keys   = nullptr;          // [2^16] -> key*
-uint8_t***  L2_tables = nullptr;          // [2^16] -> (uint8_t*[256]) or nullptr
-uint8_t**** L3_tables = nullptr;          // [2^16] -> (uint8_t**[256]) or nullptr
+static inline uint32_t dxr_lookup(const uint32_t* pool, uint32_t ip){
+    uint32_t e = pool[ip >> 16];
+    if(e & BLOCK_FLAG) e = pool[size_t(e & ~BLOCK_FLAG) * BLOCK + ((ip >> 8) & 0xFFu)];
+    if(e & BLOCK_FLAG) e = pool[size_t(e & ~BLOCK_FLAG) * BLOCK + (ip & 0xFFu)];
+    return e;
+}
 
 // ---------------- Bloom filter ----------------
 struct Bloom {
@@ -117,7 +172,7 @@ struct Bloom {
         // two-hash trick: h_i = h1 + i*h2
         for(int i=0;i<k;++i){
             uint64_t hi = h1 + uint64_t(i) * h2;
-            size_t idx = size_t(hi % m_bits);
+            size_t idx = size_t(hi & (m_bits - 1));   // m_bits is a power of two
             setbit(idx);
         }
     }
@@ -126,7 +181,7 @@ struct Bloom {
         uint64_t h2 = splitmix64(key ^ seed2);
         for(int i=0;i<k;++i){
             uint64_t hi = h1 + uint64_t(i) * h2;
-            size_t idx = size_t(hi % m_bits);
+            size_t idx = size_t(hi & (m_bits - 1));
             if(!testbit(idx)) return false; // definitely not present
         }
         return true; // possibly present
@@ -135,6 +190,218 @@ struct Bloom {
     double mem_mb() const { return to_mb(bits.size() * sizeof(uint64_t)); }
 };
 
+// ---------------- Blocked Bloom filter ----------------
+// All k=8 bits of a key live in one 64-byte block (one cache line): the upper
+// hash half picks the block, the lower half sets one bit in each of the
+// block's eight 64-bit lanes (multiply-shift with a per-lane odd salt).
+// A probe therefore costs one cache miss and, with AVX2, one test.
+struct BlockedBloom {
+    struct alignas(64) Block { uint64_t w[8]; };
+    std::vector<Block> blocks;
+    size_t m_bits = 0;
+    uint64_t block_mask = 0;
+    int k = 8;
+    uint64_t seed = 0x12345678abcdef01ULL;
+
+    static constexpr uint32_t SALT[8] = {
+        0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+        0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+    };
+
+    void init(size_t n_items, double bits_per_elem = 10.0){
+        size_t target_bits = static_cast<size_t>(std::ceil(bits_per_elem * double(n_items)));
+        size_t n_blocks = next_pow2(std::max<size_t>(1, (target_bits + 511) / 512));
+        blocks.assign(n_blocks, Block{});
+        block_mask = n_blocks - 1;
+        m_bits = n_blocks * 512;
+    }
+
+    void add(uint64_t key){
+        uint64_t h = splitmix64(key ^ seed);
+        Block& b = blocks[(h >> 32) & block_mask];
+        for(int i=0;i<8;++i) b.w[i] |= 1ULL << ((uint32_t(h) * SALT[i]) >> 26);
+    }
+    inline bool possibly_contains(uint64_t key) const {
+        uint64_t h = splitmix64(key ^ seed);
+        const Block& b = blocks[(h >> 32) & block_mask];
+#ifdef __AVX2__
+        const __m256i salt = _mm256_loadu_si256((const __m256i*)SALT);
+        __m256i pos  = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(int(uint32_t(h))), salt), 26);
+        __m256i one  = _mm256_set1_epi64x(1);
+        __m256i m_lo = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(pos)));
+        __m256i m_hi = _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(pos, 1)));
+        __m256i miss = _mm256_or_si256(
+            _mm256_andnot_si256(_mm256_load_si256((const __m256i*)&b.w[0]), m_lo),
+            _mm256_andnot_si256(_mm256_load_si256((const __m256i*)&b.w[4]), m_hi));
+        return _mm256_testz_si256(miss, miss);
+#else
+        for(int i=0;i<8;++i)
+            if(!((b.w[i] >> ((uint32_t(h) * SALT[i]) >> 26)) & 1ULL)) return false;
+        return true;
+#endif
+    }
+
+    double mem_mb() const { return to_mb(blocks.size() * sizeof(Block)); }
+};
+
+// ---------------- Cuckoo filter ----------------
+// Partial-key cuckoo hashing (Fan et al.): 4 x 16-bit fingerprints per
+// 8-byte bucket, alternate bucket = i ^ hash(fp). Unlike Bloom it supports
+// delete, so the filter can follow route withdrawals without a rebuild.
+// A lookup compares the fingerprint against both candidate buckets at once
+// (one SSE2 compare over 2 x 4 slots). Fingerprint 0 marks an empty slot.
+struct CuckooFilter {
+    static constexpr int SLOTS = 4;
+    static constexpr int MAX_KICKS = 500;
+    std::vector<uint64_t> buckets;     // 4 fingerprints per bucket
+    uint64_t bucket_mask = 0;
+    size_t m_bits = 0;
+    size_t count = 0;
+    uint64_t seed = 0x12345678abcdef01ULL;
+    uint64_t rng = 0x9e3779b97f4a7c15ULL;
+    // one evicted fingerprint that found no home (table effectively full)
+    bool     has_victim = false;
+    uint64_t victim_idx = 0;
+    uint16_t victim_fp = 0;
+
+    void init(size_t n_items){
+        // load <= ~0.84 after power-of-two rounding; 4-way buckets reach ~0.95
+        size_t n_buckets = next_pow2(std::max<size_t>(1, size_t(std::ceil(double(n_items) / (SLOTS * 0.84)))));
+        buckets.assign(n_buckets, 0);
+        bucket_mask = n_buckets - 1;
+        m_bits = n_buckets * 64;
+        count = 0; has_victim = false;
+    }
+
+    static inline uint16_t slot(uint64_t b, int s){ return uint16_t(b >> (16*s)); }
+    static inline void set_slot(uint64_t& b, int s, uint16_t fp){
+        b = (b & ~(0xFFFFULL << (16*s))) | (uint64_t(fp) << (16*s));
+    }
+    inline void index_fp(uint64_t key, uint64_t& i1, uint16_t& fp) const {
+        uint64_t h = splitmix64(key ^ seed);
+        fp = uint16_t(h); if(fp == 0) fp = 1;
+        i1 = (h >> 32) & bucket_mask;
+    }
+    inline uint64_t alt_index(uint64_t i, uint16_t fp) const {
+        return (i ^ (uint64_t(fp) * 0x5bd1e995ULL)) & bucket_mask;
+    }
+    bool put_in_bucket(uint64_t i, uint16_t fp){
+        for(int s=0;s<SLOTS;++s)
+            if(slot(buckets[i], s) == 0){ set_slot(buckets[i], s, fp); return true; }
+        return false;
+    }
+
+    // false = filter full (the key still lives in the victim slot if it was free)
+    bool insert(uint64_t key){
+        uint64_t i1; uint16_t fp; index_fp(key, i1, fp);
+        if(has_victim) return false;
+        uint64_t i2 = alt_index(i1, fp);
+        if(put_in_bucket(i1, fp) || put_in_bucket(i2, fp)){ ++count; return true; }
+        uint64_t i = (splitmix64(rng++) & 1) ? i1 : i2;
+        for(int n=0;n<MAX_KICKS;++n){
+            int s = int(splitmix64(rng++) & (SLOTS - 1));
+            uint16_t old = slot(buckets[i], s);
+            set_slot(buckets[i], s, fp);
+            fp = old;
+            i = alt_index(i, fp);
+            if(put_in_bucket(i, fp)){ ++count; return true; }
+        }
+        has_victim = true; victim_idx = i; victim_fp = fp; ++count;
+        return true;
+    }
+    bool erase(uint64_t key){
+        uint64_t i1; uint16_t fp; index_fp(key, i1, fp);
+        uint64_t i2 = alt_index(i1, fp);
+        for(uint64_t i : {i1, i2})
+            for(int s=0;s<SLOTS;++s)
+                if(slot(buckets[i], s) == fp){
+                    set_slot(buckets[i], s, 0); --count;
+                    if(has_victim){   // give the victim its place back
+                        has_victim = false; --count;
+                        insert_fp(victim_idx, victim_fp);
+                    }
+                    return true;
+                }
+        if(has_victim && victim_fp == fp && (victim_idx == i1 || victim_idx == i2)){
+            has_victim = false; --count; return true;
+        }
+        return false;
+    }
+    inline bool possibly_contains(uint64_t key) const {
+        uint64_t i1; uint16_t fp; index_fp(key, i1, fp);
+        uint64_t i2 = alt_index(i1, fp);
+        if(has_victim && victim_fp == fp && (victim_idx == i1 || victim_idx == i2)) return true;
+#if defined(__SSE2__)
+        __m128i b  = _mm_set_epi64x(int64_t(buckets[i2]), int64_t(buckets[i1]));
+        __m128i eq = _mm_cmpeq_epi16(b, _mm_set1_epi16(int16_t(fp)));
+        return _mm_movemask_epi8(eq) != 0;
+#else
+        for(uint64_t i : {i1, i2})
+            for(int s=0;s<SLOTS;++s) if(slot(buckets[i], s) == fp) return true;
+        return false;
+#endif
+    }
+
+    double mem_mb() const { return to_mb(buckets.size() * sizeof(uint64_t)); }
+
+private:
+    // re-insert a bare fingerprint whose bucket is known (victim reinsertion)
+    void insert_fp(uint64_t i, uint16_t fp){
+        if(put_in_bucket(i, fp) || put_in_bucket(alt_index(i, fp), fp)){ ++count; return; }
+        has_victim = true; victim_idx = i; victim_fp = fp; ++count;
+    }
+};
+
+// Level filter: one of the filter kinds above, chosen at run time (-f)
+enum class FilterKind { Classic, Blocked, Cuckoo };
+
+struct LevelFilter {
+    FilterKind kind = FilterKind::Blocked;
+    Bloom classic;
+    BlockedBloom blocked;
+    CuckooFilter cuckoo;
+
+    void init(FilterKind fk, size_t n_items, double bits_per_elem){
+        kind = fk;
+        if(kind == FilterKind::Classic)      classic.init(n_items, bits_per_elem);
+        else if(kind == FilterKind::Blocked) blocked.init(n_items, bits_per_elem);
+        else                                 cuckoo.init(n_items);
+    }
+    // false only if a cuckoo filter overflowed (the key is then missing)
+    bool add(uint64_t key){
+        if(kind == FilterKind::Classic)      classic.add(key);
+        else if(kind == FilterKind::Blocked) blocked.add(key);
+        else                                 return cuckoo.insert(key);
+        return true;
+    }
+    // Bloom filters cannot delete; only the cuckoo filter supports removal
+    bool remove(uint64_t key){
+        return kind == FilterKind::Cuckoo && cuckoo.erase(key);
+    }
+    bool supports_remove() const { return kind == FilterKind::Cuckoo; }
+    inline bool possibly_contains(uint64_t key) const {
+        switch(kind){
+            case FilterKind::Classic: return classic.possibly_contains(key);
+            case FilterKind::Blocked: return blocked.possibly_contains(key);
+            default:                  return cuckoo.possibly_contains(key);
+        }
+    }
+    int k() const {
+        switch(kind){
+            case FilterKind::Classic: return classic.k;
+            case FilterKind::Blocked: return blocked.k;
+            default:                  return 2;   // two candidate buckets
+        }
+    }
+    size_t m_bits() const {
+        switch(kind){
+            case FilterKind::Classic: return classic.m_bits;
+            case FilterKind::Blocked: return blocked.m_bits;
+            default:                  return cuckoo.m_bits;
+        }
+    }
+};
+
 // Level-tagged encodings so levels don't collide in Bloom
 static inline uint64_t enc_l1(uint32_t top){                 // /0..16: top 16 bits
     return (0xB100000000000000ULL) ^ (uint64_t(top) << 32);
@@ -146,14 +413,53 @@ static inline uint64_t enc_l3(uint32_t top, uint32_t mid, uint32_t low){ // /25.
     return (0xB300000000000000ULL) ^ (uint64_t(top) << 16) ^ (uint64_t(mid) << 8) ^ uint64_t(low);
 }
 
+// Level membership (what each level filter holds): every /0../16, /17../24
+// and /25../32 slot covered by a prefix of that level, sorted and unique.
+static void collect_level_keys(const std::vector<PRec>& prefixes, std::vector<uint64_t>& lv1,
+                               std::vector<uint64_t>& lv2, std::vector<uint64_t>& lv3){
+    // exact reserve, so no freed growth buffers are later reused by the filters
+    size_t n1=0, n2=0, n3=0;
+    for(const auto& rec : prefixes){
+        if(rec.len > 32 || !rec.key_id) continue;
+        if(rec.len <= 16) n1 += 1u << (16 - rec.len); else if(rec.len <= 24) n2 += 1u << (24 - rec.len); else n3 += 1u << (32 - rec.len);
+    }
+    lv1.reserve(n1); lv2.reserve(n2); lv3.reserve(n3);
+    for(const auto& rec : prefixes){
+        uint32_t net = rec.base; uint8_t len = rec.len;
+        if(len > 32 || !rec.key_id) continue;
+        uint32_t top = net >> 16, mid = (net >> 8) & 0xFFu, low = net & 0xFFu;
+        if(len <= 16)      for(uint32_t i=0;i<(1u << (16 - len));++i) lv1.push_back(enc_l1(top + i));
+        else if(len <= 24) for(uint32_t j=0;j<(1u << (24 - len));++j) lv2.push_back(enc_l2(top, mid + j));
+        else               for(uint32_t k=0;k<(1u << (32 - len));++k) lv3.push_back(enc_l3(top, mid, low + k));
+    }
+    for(auto* v : {&lv1, &lv2, &lv3}){
+        std::sort(v->begin(), v->end());
+        v->erase(std::unique(v->begin(), v->end()), v->end());
+    }
+}
+static inline bool level_has(const std::vector<uint64_t>& lv, uint64_t k){ return std::binary_search(lv.begin(), lv.end(), k); }
+
 // ---------------- Main ----------------
 int main(int argc, char* argv[]){
     bool write_hex = false;
+    FilterKind filter_kind = FilterKind::Blocked;
+    int threads = 0;
     for(int i=1;i<argc;++i){
         std::string a = argv[i];
         if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-f"||a=="--filter") && i+1<argc){
+            std::string f = argv[++i];
+            if(f=="classic")      filter_kind = FilterKind::Classic;
+            else if(f=="blocked") filter_kind = FilterKind::Blocked;
+            else if(f=="cuckoo")  filter_kind = FilterKind::Cuckoo;
+            else { std::cerr<<"Error: unknown filter '"<<f<<"'\n"; return 1; }
+        }
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
         else if(a=="-h"||a=="--help"){
-            std::cout<<"Usage: "<<argv[0]<<" [-chk]\n";
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-f classic|blocked|cuckoo] [--threads N]\n"
+                       "  -f   level filter: classic Bloom, cache-line blocked Bloom (default)\n"
+                       "       or deletable cuckoo filter\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
             return 0;
         }
     }
@@ -162,7 +468,6 @@ int main(int argc, char* argv[]){
     if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
     auto tA0=now(); size_t rA0=rss_bytes();
 
-    struct PRec{ uint32_t base; uint8_t len; uint8_t* key; };
     std::vector<PRec> prefixes; prefixes.reserve(200000);
 
     std::ifstream pf(PREFIX_FILE);
@@ -181,10 +486,10 @@ int main(int argc, char* argv[]){
         uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
         net &= mask_from_len(len);
 
-        uint8_t* key = get_or_create_key(khex);
-        if(!key) continue;
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
 
-        prefixes.push_back({net, len, key});
+        prefixes.push_back({net, len, key_id});
         ++num_prefixes;
     }
 
@@ -194,93 +499,40 @@ int main(int argc, char* argv[]){
     // -------- Phase B: Build DXR structure --------
     auto tB0=now(); size_t rB0=rss_bytes();
 
-    // allocate top-level
-    L1_keys   = new uint8_t*[L1_SIZE]();    // zeroed
-    L2_tables = new uint8_t**[L1_SIZE]();   // nullptrs
-    L3_tables = new uint8_t***[L1_SIZE]();  // nullptrs
-
-    auto ensure_L2 = [&](uint32_t top){
-        if(!L2_tables[top]) L2_tables[top] = new uint8_t*[L2_SIZE]();
-    };
-    auto ensure_L3_mid = [&](uint32_t top, uint32_t mid){
-        if(!L3_tables[top]) L3_tables[top] = new uint8_t**[L2_SIZE]();
-        if(!L3_tables[top][mid]) L3_tables[top][mid] = new uint8_t*[L3_SIZE]();
-    };
-
-    // Counters (for Bloom sizing)
-    size_t count_L1=0, count_L2=0, count_L3=0;
-
-    for(const auto& rec : prefixes){
-        uint32_t net = rec.base;
-        uint8_t  len = rec.len;
-        if(len > 32) continue;  // Skip invalid prefix lengths
-        uint8_t* key = rec.key;
-
-        if(len <= 16){
-            uint32_t start = net >> 16;
-            uint32_t fill  = 1u << (16 - len);
-            for(uint32_t i=0;i<fill;++i){
-                uint32_t idx = start + i;
-                if(!L1_keys[idx]) { L1_keys[idx] = key; ++count_L1; }
-            }
-        } else if(len <= 24){
-            uint32_t top   = net >> 16;
-            uint32_t mid_s = (net >> 8) & 0xFFu;
-            uint32_t fill  = 1u << (24 - len);
-            ensure_L2(top);
-            for(uint32_t j=0;j<fill;++j){
-                uint32_t mid = mid_s + j;
-                if(!L2_tables[top][mid]) { L2_tables[top][mid] = key; ++count_L2; }
-            }
-        } else {
-            // /25..32
-            uint32_t top   = net >> 16;
-            uint32_t mid   = (net >> 8) & 0xFFu;
-            uint32_t low_s = net & 0xFFu;
-            uint32_t fill  = 1u << (32 - len);
-            ensure_L3_mid(top, mid);
-            for(uint32_t k=0;k<fill;++k){
-                uint32_t low = low_s + k;
-                if(!L3_tables[top][mid][low]) { L3_tables[top][mid][low] = key; ++count_L3; }
-            }
-        }
-    }
+    build_key_array();
+    std::vector<uint32_t> pool = build_pool(prefixes);
+    size_t num_blocks = (pool.size() - L1_SIZE) / BLOCK;
 
     double build_ds_s = secs_since(tB0);
     double mem_ds_mb  = to_mb(rss_bytes() - rB0);
 
     // -------- Phase B2: Build Bloom filters --------
-    auto tB2=now(); size_t rB2=rss_bytes();
-
-    Bloom bfL1, bfL2, bfL3;
+    // Level key lists are kept for the FP-rate and churn phases, so they are
+    // left out of mem_bloom_mb.
+    auto tB2=now();
+    std::vector<uint64_t> lv1, lv2, lv3;
+    collect_level_keys(prefixes, lv1, lv2, lv3);
+    size_t rB2=rss_bytes();
+    size_t count_L1 = lv1.size(), count_L2 = lv2.size(), count_L3 = lv3.size();
+
+    LevelFilter bfL1, bfL2, bfL3;
     const double BITS_PER_ELEM = 10.0; // adjust as you like
-    bfL1.init(count_L1, BITS_PER_ELEM);
-    bfL2.init(count_L2, BITS_PER_ELEM);
-    bfL3.init(count_L3, BITS_PER_ELEM);
-
-    // Populate blooms by scanning the tables
-    for(int top=0; top<L1_SIZE; ++top){
-        if(L1_keys[top]) bfL1.add(enc_l1(top));
-        if(L2_tables[top]){
-            for(int mid=0; mid<L2_SIZE; ++mid){
-                if(L2_tables[top][mid]) bfL2.add(enc_l2(top, mid));
-            }
-        }
-        if(L3_tables[top]){
-            for(int mid=0; mid<L2_SIZE; ++mid){
-                if(L3_tables[top][mid]){
-                    for(int low=0; low<L3_SIZE; ++low){
-                        if(L3_tables[top][mid][low]) bfL3.add(enc_l3(top, mid, low));
-                    }
-                }
-            }
-        }
-    }
+    bfL1.init(filter_kind, count_L1, BITS_PER_ELEM);
+    bfL2.init(filter_kind, count_L2, BITS_PER_ELEM);
+    bfL3.init(filter_kind, count_L3, BITS_PER_ELEM);
+
+    size_t filter_overflow = 0;
+    for(uint64_t k : lv1) filter_overflow += !bfL1.add(k);
+    for(uint64_t k : lv2) filter_overflow += !bfL2.add(k);
+    for(uint64_t k : lv3) filter_overflow += !bfL3.add(k);
+    if(filter_overflow) std::cerr<<"Warning: "<<filter_overflow<<" keys did not fit in the cuckoo filters\n";
 
     double build_bloom_s = secs_since(tB2);
     double mem_bloom_mb  = to_mb(rss_bytes() - rB2);
+    const char* filter_name = (filter_kind == FilterKind::Classic) ? "classic"
+                            : (filter_kind == FilterKind::Blocked) ? "blocked" : "cuckoo";
 
-    // Free prefix vector to isolate DS memory (keys remain in pool)
+    // Free prefix vector to isolate DS memory
     prefixes.clear(); prefixes.shrink_to_fit();
 
     // -------- Phase C: Load IPs (batch) --------
@@ -306,33 +558,25 @@ int main(int argc, char* argv[]){
     double mem_ip_mb = to_mb(rss_bytes() - rC0);
 
     // -------- Phase D: Lookup (Bloom-guided) --------
-    auto tD0=now();
-
-    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
-    for(size_t i=0;i<ips.size();++i){
-        uint32_t ip  = ips[i];
+    // A level can only match if its filter says "maybe"; when all three
+    // say no the address has no route and the tables are never touched.
+    auto guided_lookup = [&](uint32_t ip) -> uint32_t {
         uint32_t top = ip >> 16;
         uint32_t mid = (ip >> 8) & 0xFFu;
         uint32_t low = ip & 0xFFu;
+        if(bfL3.possibly_contains(enc_l3(top, mid, low)) ||
+           bfL2.possibly_contains(enc_l2(top, mid)) ||
+           bfL1.possibly_contains(enc_l1(top)))
+            return dxr_lookup(pool.data(), ip);
+        return 0;
+    };
 
-        uint8_t* key = nullptr;
+    auto tD0=now();
 
-        // L3 check with Bloom to skip obvious negatives
-        if(bfL3.possibly_contains(enc_l3(top, mid, low))){
-            if(L3_tables[top] && L3_tables[top][mid]){
-                key = L3_tables[top][mid][low];
-            }
-        }
-        // If not found, try L2
-        if(!key && bfL2.possibly_contains(enc_l2(top, mid))){
-            if(L2_tables[top]){
-                key = L2_tables[top][mid];
-            }
-        }
-        // If still not found, try L1
-        if(!key && bfL1.possibly_contains(enc_l1(top))){
-            key = L1_keys[top];
-        }
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint32_t id = guided_lookup(ips[i]);
+        const uint8_t* key = id ? g_key_array + size_t(id)*64 : nullptr;
 
         if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
         else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
@@ -342,6 +586,52 @@ int main(int argc, char* argv[]){
     double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
     double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
 
+    // -------- Phase E: Filter probe cost + measured false-positive rate --------
+    // Probes all three level filters per IP, so the timing covers hits and misses.
+    size_t probe_hits = 0;
+    auto tE0=now();
+    for(uint32_t ip : ips){
+        uint32_t top = ip >> 16, mid = (ip >> 8) & 0xFFu, low = ip & 0xFFu;
+        probe_hits += bfL3.possibly_contains(enc_l3(top, mid, low));
+        probe_hits += bfL2.possibly_contains(enc_l2(top, mid));
+        probe_hits += bfL1.possibly_contains(enc_l1(top));
+    }
+    double probe_s = secs_since(tE0);
+    volatile size_t probe_sink = probe_hits; (void)probe_sink;   // keep the probe loop alive
+    double bloom_ns_per_probe = ips.empty()? 0.0 : (probe_s*1e9 / double(3*ips.size()));
+
+    // False positive = filter says "maybe" but the level slot is empty.
+    size_t negatives = 0, false_pos = 0;
+    for(uint32_t ip : ips){
+        uint32_t top = ip >> 16, mid = (ip >> 8) & 0xFFu, low = ip & 0xFFu;
+        bool in3 = level_has(lv3, enc_l3(top, mid, low));
+        bool in2 = level_has(lv2, enc_l2(top, mid));
+        bool in1 = level_has(lv1, enc_l1(top));
+        if(!in3){ ++negatives; false_pos += bfL3.possibly_contains(enc_l3(top, mid, low)); }
+        if(!in2){ ++negatives; false_pos += bfL2.possibly_contains(enc_l2(top, mid)); }
+        if(!in1){ ++negatives; false_pos += bfL1.possibly_contains(enc_l1(top)); }
+    }
+    double bloom_fp_rate = negatives ? double(false_pos) / double(negatives) : 0.0;
+
+    // -------- Phase F: Filter update cost (route churn) --------
+    // Withdraw and re-announce up to 100k /25../32 level entries. Only the
+    // cuckoo filter can do this in place; Bloom filters report NA (rebuild).
+    std::string filter_update_ns = "NA";
+    if(bfL3.supports_remove()){
+        std::vector<uint64_t> churn(lv3.begin(), lv3.begin() + std::min<size_t>(lv3.size(), 100000));
+        size_t update_fail = 0;
+        auto tF0=now();
+        for(uint64_t k : churn){
+            update_fail += !bfL3.remove(k);
+            update_fail += !bfL3.add(k);
+        }
+        double update_s = secs_since(tF0);
+        if(update_fail) std::cerr<<"Warning: "<<update_fail<<" cuckoo filter updates failed\n";
+        std::ostringstream oss;
+        oss<<std::fixed<<std::setprecision(2)<<(churn.empty()? 0.0 : update_s*1e9 / double(2*churn.size()));
+        filter_update_ns = oss.str();
+    }
+
     // -------- Write match file --------
     {
         std::ofstream out(MATCH_FILE);
@@ -359,7 +649,8 @@ int main(int argc, char* argv[]){
               "lookups_per_s,ns_per_lookup,"
               "mem_prefix_array_mb,mem_ds_mb,mem_bloom_mb,mem_ip_array_mb,mem_total_mb,"
               "bf_bits_per_elem,k_l1,k_l2,k_l3,count_l1,count_l2,count_l3,"
-              "m_bits_l1,m_bits_l2,m_bits_l3\n";
+              "m_bits_l1,m_bits_l2,m_bits_l3,"
+              "filter,bloom_ns_per_probe,bloom_fp_rate,filter_update_ns,num_blocks\n";
     }
     res<<"DXR-16-8-8+Bloom"<<','
        <<PREFIX_FILE<<','<<IP_FILE<<','
@@ -371,32 +662,18 @@ int main(int argc, char* argv[]){
        <<std::setprecision(2)
        <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_bloom_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
        <<std::setprecision(2)
-       <<10.0<<','<<bfL1.k<<','<<bfL2.k<<','<<bfL3.k<<','
+       <<10.0<<','<<bfL1.k()<<','<<bfL2.k()<<','<<bfL3.k()<<','
        <<count_L1<<','<<count_L2<<','<<count_L3<<','
-       <<bfL1.m_bits<<','<<bfL2.m_bits<<','<<bfL3.m_bits<<'\n';
+       <<bfL1.m_bits()<<','<<bfL2.m_bits()<<','<<bfL3.m_bits()<<','
+       <<filter_name<<','<<bloom_ns_per_probe<<','
+       <<std::setprecision(6)<<bloom_fp_rate<<','<<filter_update_ns<<','<<num_blocks<<'\n';
 
-    // -------- Cleanup (keys + tables) --------
-    for(auto& kv : g_key_pool) delete[] kv.second;
-    g_key_pool.clear();
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark(std::string("DXR-16-8-8+Bloom-") + filter_name, ips, threads, guided_lookup);
 
-    if(L3_tables){
-        for(int top=0; top<L1_SIZE; ++top){
-            if(L3_tables[top]){
-                for(int mid=0; mid<L2_SIZE; ++mid){
-                    if(L3_tables[top][mid]) delete[] L3_tables[top][mid];
-                }
-                delete[] L3_tables[top];
-            }
-        }
-        delete[] L3_tables;
-    }
-    if(L2_tables){
-        for(int top=0; top<L1_SIZE; ++top){
-            if(L2_tables[top]) delete[] L2_tables[top];
-        }
-        delete[] L2_tables;
-    }
-    if(L1_keys) delete[] L1_keys;
+    // -------- Cleanup --------
+    std::free(g_key_array);
 
     return 0;
 }
@@ -0,0 +1,313 @@
+// src/dxr_range.cpp
+// DXR (Zec/Rizzo/Mikuc) range-table lookup: D16R / D18R.
+//
+// The prefix table is flattened into disjoint address ranges, each carrying the
+// key id of its longest matching prefix. The upper K bits of an address index a
+// direct chunk table; a chunk covered by a single range stores the key id
+// directly, otherwise it points to a sorted slice of the range array that is
+// binary-searched on the remaining 32-K bits.
+//
+// Range formats:
+//   short: {uint16 start, uint16 key_id}  (chunk's key ids all fit in 16 bits)
+//   long:  {uint32 start, uint32 key_id}
+// Our tables carry one distinct key per prefix, so the format is chosen by key id
+// width rather than by next-hop count as in the paper.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include "mt_lookup.h"
+#include "range_build.h"
+
+// ---------------- Paths ----------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_dxr_range.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_dxr_range.csv";
+
+// ---------------- Utils ----------------
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t){ return std::chrono::duration<double>(now()-t).count(); }
+
+static inline size_t rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size(); i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
+    std::ostringstream oss;
+    for(int i=0;i<len;++i) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(key[i]);
+    return oss.str();
+}
+
+// ---------------- Key pool (dedup, id-indexed) ----------------
+// key id 0 is reserved for "no match"
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t*> g_keys(1, nullptr);
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
+    std::vector<uint8_t> tmp = hex_to_bytes(hex);
+    if(tmp.size() != 64) return 0;
+    uint8_t* p = new uint8_t[64];
+    std::memcpy(p, tmp.data(), 64);
+    uint32_t id = uint32_t(g_keys.size());
+    g_keys.push_back(p);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ---------------- DXR tables ----------------
+struct ShortRange{ uint16_t start; uint16_t key_id; };
+struct LongRange { uint32_t start; uint32_t key_id; };
+
+// info == 0           -> base is the key id for the whole chunk
+// info == (n<<1)|fmt  -> n ranges at base in the short (fmt=0) or long (fmt=1) array
+struct Chunk{ uint32_t base; uint32_t info; };
+
+struct Dxr {
+    int k_bits = 16;
+    int shift  = 16;                 // 32 - k_bits
+    uint32_t off_mask = 0xFFFFu;
+    std::vector<Chunk>      direct;
+    std::vector<ShortRange> short_ranges;
+    std::vector<LongRange>  long_ranges;
+    size_t direct_chunks = 0;
+
+    void build(const std::vector<Range>& ranges, int k){
+        k_bits = k; shift = 32 - k;
+        off_mask = (shift == 32) ? ~0U : ((1U << shift) - 1);
+        const uint64_t n_chunks = uint64_t(1) << k;
+        direct.assign(n_chunks, Chunk{0, 0});
+
+        size_t r = 0;   // index of the range covering the current chunk start
+        for(uint64_t c = 0; c < n_chunks; ++c){
+            uint64_t c_start = c << shift;
+            uint64_t c_end   = c_start + (uint64_t(1) << shift);   // exclusive
+            while(r + 1 < ranges.size() && ranges[r+1].start <= c_start) ++r;
+
+            size_t last = r;
+            while(last + 1 < ranges.size() && ranges[last+1].start < c_end) ++last;
+
+            if(last == r){
+                direct[c] = Chunk{ranges[r].key_id, 0};
+                ++direct_chunks;
+                continue;
+            }
+
+            uint32_t n = uint32_t(last - r + 1);
+            bool fits_short = (shift <= 16);
+            for(size_t i = r; i <= last && fits_short; ++i)
+                if(ranges[i].key_id > 0xFFFFu) fits_short = false;
+
+            if(fits_short){
+                direct[c] = Chunk{uint32_t(short_ranges.size()), (n << 1) | 0u};
+                for(size_t i = r; i <= last; ++i){
+                    uint32_t off = (i == r) ? 0u : uint32_t(ranges[i].start - c_start);
+                    short_ranges.push_back({uint16_t(off), uint16_t(ranges[i].key_id)});
+                }
+            } else {
+                direct[c] = Chunk{uint32_t(long_ranges.size()), (n << 1) | 1u};
+                for(size_t i = r; i <= last; ++i){
+                    uint32_t off = (i == r) ? 0u : uint32_t(ranges[i].start - c_start);
+                    long_ranges.push_back({off, ranges[i].key_id});
+                }
+            }
+            r = last;
+        }
+    }
+
+    // last entry with start <= off; entry 0 always starts at offset 0
+    template<typename R>
+    static inline uint32_t search(const R* rs, uint32_t n, uint32_t off){
+        uint32_t lo = 0, hi = n - 1;
+        while(lo < hi){
+            uint32_t mid = (lo + hi + 1) >> 1;
+            if(rs[mid].start <= off) lo = mid; else hi = mid - 1;
+        }
+        return rs[lo].key_id;
+    }
+
+    inline uint32_t lookup(uint32_t ip) const {
+        const Chunk& e = direct[ip >> shift];
+        if(e.info == 0) return e.base;
+        uint32_t off = ip & off_mask;
+        uint32_t n = e.info >> 1;
+        if(e.info & 1u) return search(long_ranges.data()  + e.base, n, off);
+        return search(short_ranges.data() + e.base, n, off);
+    }
+
+    size_t bytes() const {
+        return direct.size()*sizeof(Chunk)
+             + short_ranges.size()*sizeof(ShortRange)
+             + long_ranges.size()*sizeof(LongRange);
+    }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    int threads = 0;
+    int k_bits = 16;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if(a=="-d16"||a=="--d16") k_bits = 16;
+        else if(a=="-d18"||a=="--d18") k_bits = 18;
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-d16|-d18] [--threads N]\n"
+                       "  -chk   Write hex keys to match file (slower)\n"
+                       "  -d16   16-bit direct chunk table (D16R, default)\n"
+                       "  -d18   18-bit direct chunk table (D18R)\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0=now(); size_t rA0=rss_bytes();
+
+    std::vector<PRec> prefixes; prefixes.reserve(200000);
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf, line); // header "prefix,key"
+
+    size_t num_prefixes=0;
+    while(std::getline(pf, line)){
+        std::istringstream ss(line);
+        std::string pfx, khex;
+        if(!std::getline(ss, pfx, ',')) continue;
+        if(!std::getline(ss, khex)) continue;
+
+        auto slash = pfx.find('/');
+        if(slash == std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0, slash));
+        uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
+
+        prefixes.push_back({net, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    double mem_prefix_mb = to_mb(rss_bytes() - rA0);
+
+    // -------- Phase B: Build DXR structure --------
+    auto tB0=now(); size_t rB0=rss_bytes();
+
+    Dxr dxr;
+    size_t num_ranges = 0;
+    {
+        std::vector<Range> ranges = build_ranges(prefixes);
+        num_ranges = ranges.size();
+        dxr.build(ranges, k_bits);
+    }
+
+    double build_ds_s = secs_since(tB0);
+    double mem_ds_mb  = to_mb(rss_bytes() - rB0);
+
+    prefixes.clear(); prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rC0=rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header "ip,used_prefix"
+
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    std::vector<uint32_t>    ips;     ips.reserve(1<<20);
+
+    while(std::getline(ipf, line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss, ip_s, ',')) continue;
+        std::getline(ss, dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    double mem_ip_mb = to_mb(rss_bytes() - rC0);
+
+    // -------- Phase D: Lookup --------
+    auto tD0=now();
+
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint8_t* key = g_keys[dxr.lookup(ips[i])];
+        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
+    }
+
+    double lookup_s = secs_since(tD0);
+    double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write match file --------
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r : results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // -------- Metrics CSV (MB) --------
+    double mem_total_mb = to_mb(rss_bytes());
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "k_bits,num_ranges,direct_chunks,short_ranges,long_ranges,dxr_struct_mb\n";
+    }
+    res<<(k_bits == 18 ? "DXR-D18R" : "DXR-D16R")<<','
+       <<PREFIX_FILE<<','<<IP_FILE<<','
+       <<num_prefixes<<','<<ips.size()<<','
+       <<std::fixed<<std::setprecision(6)
+       <<prefix_load_s<<','<<build_ds_s<<','<<ip_load_s<<','<<lookup_s<<','
+       <<std::setprecision(2)
+       <<lookups_per_s<<','<<ns_per_lookup<<','
+       <<std::setprecision(2)
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
+       <<k_bits<<','<<num_ranges<<','<<dxr.direct_chunks<<','
+       <<dxr.short_ranges.size()<<','<<dxr.long_ranges.size()<<','
+       <<std::setprecision(4)<<to_mb(dxr.bytes())<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark((k_bits == 18 ? "DXR-D18R" : "DXR-D16R"), ips, threads, [&](uint32_t ip){ return dxr.lookup(ip)!=0; });
+
+    // -------- Cleanup (keys) --------
+    for(auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
@@ -0,0 +1,265 @@
+// src/eytzinger.cpp
+// Range search over prefix interval starts stored in Eytzinger (BFS) order.
+//
+// The prefix table is flattened into disjoint address ranges, each carrying the
+// key id of its longest matching prefix. The range starts are laid out as an
+// implicit binary tree (node k has children 2k and 2k+1), so the top levels
+// share a few cache lines and the search needs no pointers. The descent is
+// branchless and prefetches the node 4 levels down (16 uint32 = one line).
+//
+// The descent finds the first start > ip; every slot also stores the key id of
+// its in-order predecessor, which is the range that contains ip.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>   // aligned_alloc
+#include "mt_lookup.h"
+#include "range_build.h"
+
+// ---------------- Paths ----------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_eytzinger.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_eytzinger.csv";
+
+// ---------------- Utils ----------------
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t){ return std::chrono::duration<double>(now()-t).count(); }
+
+static inline size_t rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size(); i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
+    std::ostringstream oss;
+    for(int i=0;i<len;++i) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(key[i]);
+    return oss.str();
+}
+
+// ---------------- Key pool (dedup, id-indexed) ----------------
+// key id 0 is reserved for "no match"
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t*> g_keys(1, nullptr);
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
+    std::vector<uint8_t> tmp = hex_to_bytes(hex);
+    if(tmp.size() != 64) return 0;
+    uint8_t* p = new uint8_t[64];
+    std::memcpy(p, tmp.data(), 64);
+    uint32_t id = uint32_t(g_keys.size());
+    g_keys.push_back(p);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ---------------- Eytzinger layout ----------------
+// start[k] / prev_key[k] for k = 1..n in BFS order; slot 0 is padding so that
+// the 16 grandchildren 16k..16k+15 of node k share one 64-byte line.
+// prev_key[0] holds the key id of the last range (ip above every start).
+struct Eytzinger {
+    uint32_t* start    = nullptr;
+    uint32_t* prev_key = nullptr;
+    uint32_t n = 0;
+
+    static uint32_t* alloc_aligned(size_t count){
+        size_t bytes = (count * sizeof(uint32_t) + 63) & ~size_t(63);
+        return static_cast<uint32_t*>(std::aligned_alloc(64, bytes));
+    }
+
+    void build(const std::vector<Range>& ranges){
+        n = uint32_t(ranges.size());
+        start    = alloc_aligned(n + 1);
+        prev_key = alloc_aligned(n + 1);
+        start[0] = 0;
+        prev_key[0] = ranges.back().key_id;
+
+        // in-order walk of the implicit tree visits the sorted ranges in order
+        size_t i = 0;
+        std::vector<uint32_t> stack;
+        uint32_t k = 1;
+        while(k <= n || !stack.empty()){
+            while(k <= n){ stack.push_back(k); k = 2*k; }
+            k = stack.back(); stack.pop_back();
+            start[k]    = ranges[i].start;
+            prev_key[k] = (i == 0) ? 0 : ranges[i-1].key_id;
+            ++i;
+            k = 2*k + 1;
+        }
+    }
+
+    inline uint32_t lookup(uint32_t ip) const {
+        uint32_t k = 1;
+        while(k <= n){
+            __builtin_prefetch(start + 16*size_t(k));
+            k = 2*k + (start[k] <= ip);
+        }
+        // strip the trailing right turns: k becomes the first start > ip (0 if none)
+        k >>= __builtin_ffs(~k);
+        return prev_key[k];
+    }
+
+    int depth() const { int d = 0; for(uint32_t m = n; m; m >>= 1) ++d; return d; }
+    size_t bytes() const { return 2 * size_t(n + 1) * sizeof(uint32_t); }
+
+    ~Eytzinger(){ std::free(start); std::free(prev_key); }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    int threads = 0;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [--threads N]\n"
+                       "  -chk   Write hex keys to match file (slower)\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0=now(); size_t rA0=rss_bytes();
+
+    std::vector<PRec> prefixes; prefixes.reserve(200000);
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf, line); // header "prefix,key"
+
+    size_t num_prefixes=0;
+    while(std::getline(pf, line)){
+        std::istringstream ss(line);
+        std::string pfx, khex;
+        if(!std::getline(ss, pfx, ',')) continue;
+        if(!std::getline(ss, khex)) continue;
+
+        auto slash = pfx.find('/');
+        if(slash == std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0, slash));
+        uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
+
+        prefixes.push_back({net, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    double mem_prefix_mb = to_mb(rss_bytes() - rA0);
+
+    // -------- Phase B: Build Eytzinger range array --------
+    auto tB0=now(); size_t rB0=rss_bytes();
+
+    Eytzinger eyt;
+    eyt.build(build_ranges(prefixes));
+
+    double build_ds_s = secs_since(tB0);
+    double mem_ds_mb  = to_mb(rss_bytes() - rB0);
+
+    prefixes.clear(); prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rC0=rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header "ip,used_prefix"
+
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    std::vector<uint32_t>    ips;     ips.reserve(1<<20);
+
+    while(std::getline(ipf, line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss, ip_s, ',')) continue;
+        std::getline(ss, dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    double mem_ip_mb = to_mb(rss_bytes() - rC0);
+
+    // -------- Phase D: Lookup --------
+    auto tD0=now();
+
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint8_t* key = g_keys[eyt.lookup(ips[i])];
+        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
+    }
+
+    double lookup_s = secs_since(tD0);
+    double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write match file --------
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r : results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // -------- Metrics CSV (MB) --------
+    double mem_total_mb = to_mb(rss_bytes());
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "num_ranges,tree_depth,eyt_struct_mb\n";
+    }
+    res<<"Eytzinger"<<','
+       <<PREFIX_FILE<<','<<IP_FILE<<','
+       <<num_prefixes<<','<<ips.size()<<','
+       <<std::fixed<<std::setprecision(6)
+       <<prefix_load_s<<','<<build_ds_s<<','<<ip_load_s<<','<<lookup_s<<','
+       <<std::setprecision(2)
+       <<lookups_per_s<<','<<ns_per_lookup<<','
+       <<std::setprecision(2)
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
+       <<eyt.n<<','<<eyt.depth()<<','
+       <<std::setprecision(4)<<to_mb(eyt.bytes())<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark("Eytzinger", ips, threads, [&](uint32_t ip){ return eyt.lookup(ip)!=0; });
+
+    // -------- Cleanup (keys) --------
+    for(auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
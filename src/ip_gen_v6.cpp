@@ -0,0 +1,114 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <random>
+#include <iomanip>
+#include <unordered_set>
+#include <arpa/inet.h>
+#include <utility>
+#include <cstdlib>
+#include <cstdint>
+
+// IPv6 counterpart of ip_gen.cpp: reads data/prefix_table_v6.csv and writes
+// data/generated_ips_v6.csv with one random address inside a random prefix.
+
+typedef unsigned __int128 u128;
+
+u128 ip6_str_to_u128(const std::string& ip_str) {
+    in6_addr addr{};
+    inet_pton(AF_INET6, ip_str.c_str(), &addr);
+    u128 v = 0;
+    for (int i = 0; i < 16; ++i) v = (v << 8) | addr.s6_addr[i];
+    return v;
+}
+
+std::string u128_to_ip6_str(u128 ip) {
+    in6_addr addr;
+    for (int i = 0; i < 16; ++i)
+        addr.s6_addr[i] = static_cast<uint8_t>(ip >> (120 - 8 * i));
+    char ip_buf[INET6_ADDRSTRLEN];
+    inet_ntop(AF_INET6, &addr, ip_buf, INET6_ADDRSTRLEN);
+    return std::string(ip_buf);
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <num_ips_to_generate>\n";
+        return 1;
+    }
+
+    int N = std::stoi(argv[1]);
+    if (N <= 0) {
+        std::cerr << "Number of IPs must be positive.\n";
+        return 1;
+    }
+
+    // Input: prefix table in data/
+    std::ifstream file("data/prefix_table_v6.csv");
+    if (!file.is_open()) {
+        std::cerr << "Error: Could not open data/prefix_table_v6.csv\n";
+        return 1;
+    }
+
+    std::string line;
+    std::getline(file, line); // skip header
+
+    std::vector<std::pair<u128, uint8_t>> prefixes;
+    std::vector<std::string> prefix_strings;
+
+    while (std::getline(file, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',') || !std::getline(ss, key_hex)) continue;
+
+        auto slash_pos = prefix_str.find('/');
+        std::string ip_str = prefix_str.substr(0, slash_pos);
+        uint8_t prefix_len = std::stoi(prefix_str.substr(slash_pos + 1));
+        u128 ip = ip6_str_to_u128(ip_str);
+        u128 mask = prefix_len == 0 ? 0 : (~u128(0) << (128 - prefix_len));
+        ip = ip & mask;  // align to prefix boundary
+
+        prefixes.emplace_back(ip, prefix_len);
+        prefix_strings.push_back(prefix_str);
+    }
+    if (prefixes.empty()) {
+        std::cerr << "Error: no prefixes in data/prefix_table_v6.csv\n";
+        return 1;
+    }
+
+    // Output: generated IPs in data/
+    std::ofstream out("data/generated_ips_v6.csv");
+    if (!out.is_open()) {
+        std::cerr << "Error: Could not open data/generated_ips_v6.csv for writing\n";
+        return 1;
+    }
+
+    out << "ip,used_prefix\n";
+
+    std::random_device rd;
+    std::mt19937_64 gen(rd());
+    std::unordered_set<std::string> generated_ips;
+    std::uniform_int_distribution<size_t> prefix_dist(0, prefixes.size() - 1);
+
+    int count = 0;
+    while (count < N) {
+        size_t idx = prefix_dist(gen);
+
+        u128 base_ip = prefixes[idx].first;
+        uint8_t len = prefixes[idx].second;
+        u128 host_mask = (len == 0) ? ~u128(0) : ~(~u128(0) << (128 - len));
+        if (len == 128) host_mask = 0;
+        u128 suffix = ((u128(gen()) << 64) | gen()) & host_mask;
+        std::string ip = u128_to_ip6_str(base_ip | suffix);
+
+        if (generated_ips.insert(ip).second) {
+            out << ip << "," << prefix_strings[idx] << "\n";
+            ++count;
+        }
+    }
+
+    std::cout << "Generated " << N << " unique IPs using prefixes from data/prefix_table_v6.csv\n";
+    return 0;
+}
@@ -0,0 +1,345 @@
+// lc_trie.cpp
+// Level- and path-compressed trie (Nilsson & Karlsson, "IP-address lookup using LC-tries").
+//
+// The trie is one contiguous array of 8-byte nodes. An internal node consumes
+// `skip` bits (path compression) and then `branch` bits that index its 2^branch
+// children, which are stored next to each other (level compression). The
+// branching factor grows while at least fill_factor * 2^branch of the child
+// slots would be non-empty. Leaves point into a separate prefix vector whose
+// entries chain to their longest proper prefix; next hops (keys) live in a
+// third vector indexed by the prefix entries.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstdint>
+#include "mt_lookup.h"
+
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_lc.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_lc.csv";
+
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size();i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2),nullptr,16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const std::vector<uint8_t>& b){
+    std::ostringstream oss; for(auto v: b) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(v); return oss.str();
+}
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t0){
+    return std::chrono::duration<double>(now()-t0).count();
+}
+static inline size_t current_rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res*size_t(sysconf(_SC_PAGESIZE));
+}
+static inline double bytes_to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+struct LcNode {
+    uint32_t adr;     // internal: first child; leaf: prefix index + 1 (0 = no match)
+    uint8_t  branch;  // 0 for leaves
+    uint8_t  skip;
+};
+
+struct LcPrefix {
+    uint32_t str;     // aligned network address
+    uint8_t  len;
+    uint32_t key_id;  // index into the key (next-hop) vector
+    int32_t  pre;     // longest proper prefix in the table, -1 if none
+};
+
+class LcTrie {
+public:
+    struct Rec{ uint32_t net; uint8_t len; std::vector<uint8_t> key; };
+
+    LcTrie(double fill_factor, int root_branch)
+        : fill_(fill_factor), root_branch_(root_branch) {}
+
+    void build(std::vector<Rec>& recs){
+        // sort by (address, length); ancestors precede descendants
+        std::vector<uint32_t> order(recs.size());
+        for(uint32_t i=0;i<order.size();++i) order[i]=i;
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){
+            return recs[a].net != recs[b].net ? recs[a].net < recs[b].net : recs[a].len < recs[b].len;
+        });
+
+        // prefix vector with prefix-chain pointers; duplicates keep the last key
+        std::vector<int32_t> open;
+        for(uint32_t i : order){
+            Rec& r = recs[i];
+            if(!pre_.empty() && pre_.back().str == r.net && pre_.back().len == r.len){
+                keys_[pre_.back().key_id] = std::move(r.key);
+                continue;
+            }
+            while(!open.empty() && !covers(pre_[open.back()], r.net, r.len)) open.pop_back();
+            keys_.push_back(std::move(r.key));
+            pre_.push_back({r.net, r.len, uint32_t(keys_.size()-1), open.empty() ? -1 : open.back()});
+            open.push_back(int32_t(pre_.size()-1));
+        }
+
+        // base vector: entries that are not a prefix of the next entry
+        for(size_t i=0;i<pre_.size();++i){
+            if(i+1 < pre_.size() && covers(pre_[i], pre_[i+1].str, pre_[i+1].len)) continue;
+            base_.push_back(int32_t(i));
+        }
+
+        trie_.assign(1, LcNode{0,0,0});
+        if(!base_.empty()) build_rec(0, base_.size(), 0, 0, root_branch_);
+        base_.clear(); base_.shrink_to_fit();
+    }
+
+    const std::vector<uint8_t>* lpm(uint32_t ip) const {
+        const LcNode* t = trie_.data();
+        LcNode node = t[0];
+        uint32_t pos = node.skip, branch = node.branch, adr = node.adr;
+        while(branch){
+            node = t[adr + ((ip << pos) >> (32 - branch))];
+            pos += branch + node.skip;
+            branch = node.branch;
+            adr = node.adr;
+        }
+        for(int32_t p = int32_t(adr) - 1; p >= 0; p = pre_[p].pre){
+            const LcPrefix& e = pre_[p];
+            if(((ip ^ e.str) & mask_from_len(e.len)) == 0) return &keys_[e.key_id];
+        }
+        return nullptr;
+    }
+
+    size_t node_count() const { return trie_.size(); }
+    size_t prefix_count() const { return pre_.size(); }
+    size_t bytes() const { return trie_.size()*sizeof(LcNode) + pre_.size()*sizeof(LcPrefix); }
+
+private:
+    double fill_;
+    int root_branch_;
+    std::vector<LcNode> trie_;
+    std::vector<LcPrefix> pre_;
+    std::vector<std::vector<uint8_t>> keys_;
+    std::vector<int32_t> base_;   // build-time only
+
+    static bool covers(const LcPrefix& p, uint32_t net, uint8_t len){
+        return p.len <= len && ((net ^ p.str) & mask_from_len(p.len)) == 0;
+    }
+    uint32_t bstr(size_t i) const { return pre_[base_[i]].str; }
+    static uint32_t bits(uint32_t s, uint32_t pos, uint32_t n){
+        return n ? (s << pos) >> (32 - n) : 0;
+    }
+
+    // Longest table prefix covering the whole region (str,len). Any such prefix
+    // lies on the prefix chain of the base entry just left or right of the
+    // region, because those entries are contiguous in sorted order.
+    int32_t best_cover(uint32_t str, uint32_t len, size_t right) const {
+        int32_t best = -1;
+        auto scan = [&](size_t bi){
+            for(int32_t p = base_[bi]; p >= 0; p = pre_[p].pre){
+                const LcPrefix& e = pre_[p];
+                if(e.len <= len && ((str ^ e.str) & mask_from_len(e.len)) == 0){
+                    if(best < 0 || e.len > pre_[best].len) best = p;
+                    break;
+                }
+            }
+        };
+        if(right > 0) scan(right - 1);
+        if(right < base_.size()) scan(right);
+        return best;
+    }
+
+    // Build the subtree for base_[first, first+n) whose common bits start at
+    // `pos`, writing it into trie_[at].
+    void build_rec(size_t first, size_t n, uint32_t pos, size_t at, int fixed_branch){
+        if(n == 1){
+            trie_[at] = LcNode{uint32_t(base_[first]) + 1, 0, 0};
+            return;
+        }
+
+        uint32_t skip = 0, branch = 1;
+        if(fixed_branch > 0){
+            branch = uint32_t(fixed_branch);
+        } else {
+            uint32_t x = (bstr(first) ^ bstr(first + n - 1)) << pos;
+            skip = uint32_t(__builtin_clz(x));   // base entries are prefix-free, so x != 0
+            uint32_t p = pos + skip;
+            while(p + branch < 32){
+                uint32_t b = branch + 1, distinct = 0;
+                uint32_t last = ~0U;
+                for(size_t i=first;i<first+n;++i){
+                    uint32_t pat = bits(bstr(i), p, b);
+                    if(pat != last){ ++distinct; last = pat; }
+                }
+                if(double(distinct) < fill_ * double(1u << b)) break;
+                branch = b;
+            }
+        }
+
+        uint32_t p = pos + skip;
+        size_t adr = trie_.size();
+        trie_.resize(adr + (size_t(1) << branch));
+        trie_[at] = LcNode{uint32_t(adr), uint8_t(branch), uint8_t(skip)};
+
+        size_t i = first;
+        for(uint32_t pat = 0; pat < (1u << branch); ++pat){
+            size_t k = 0;
+            while(i + k < first + n && bits(bstr(i + k), p, branch) == pat) ++k;
+            if(k == 0){
+                uint32_t len = p + branch;
+                uint32_t str = (bstr(first) & mask_from_len(uint8_t(p))) | (pat << (32 - len));
+                trie_[adr + pat] = LcNode{uint32_t(best_cover(str, len, i) + 1), 0, 0};
+            } else {
+                build_rec(i, k, p + branch, adr + pat, 0);
+            }
+            i += k;
+        }
+    }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    double fill_factor = 0.5;
+    int root_branch = 16;
+    int threads = 0;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex=true;
+        else if((a=="-f"||a=="--fill") && i+1<argc) fill_factor = std::stod(argv[++i]);
+        else if((a=="-r"||a=="--root") && i+1<argc) root_branch = std::stoi(argv[++i]);
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-f fill_factor] [-r root_branch] [--threads N]\n"
+                       "  -f   Fill factor in (0,1] for level compression (default 0.5)\n"
+                       "  -r   Fixed branching at the root, 0 = adaptive (default 16)\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+    if(fill_factor <= 0.0 || fill_factor > 1.0 || root_branch < 0 || root_branch > 24){
+        std::cerr<<"Error: need 0 < fill_factor <= 1 and 0 <= root_branch <= 24\n";
+        return 1;
+    }
+
+    // Phase A: load prefixes
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0 = now(); size_t rssA0 = current_rss_bytes();
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf,line); // header
+    std::vector<LcTrie::Rec> recs; recs.reserve(200000);
+    size_t num_prefixes=0;
+    while(std::getline(pf,line)){
+        std::istringstream ss(line);
+        std::string pfx, key_hex;
+        if(!std::getline(ss,pfx,',')||!std::getline(ss,key_hex)) continue;
+        auto slash=pfx.find('/'); if(slash==std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0,slash));
+        uint8_t len = uint8_t(std::stoi(pfx.substr(slash+1)));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+        recs.push_back({net,len,hex_to_bytes(key_hex)});
+        ++num_prefixes;
+    }
+    double prefix_load_s = secs_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1>rssA0? rssA1-rssA0:0);
+
+    // Phase B: build LC-trie from the sorted prefix list
+    auto tB0 = now(); size_t rssB0 = current_rss_bytes();
+    LcTrie trie(fill_factor, root_branch);
+    trie.build(recs);
+    double build_ds_s = secs_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1>rssB0? rssB1-rssB0:0);
+
+    recs.clear(); recs.shrink_to_fit();
+
+    // Phase C: load IPs
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rssC0=current_rss_bytes();
+    std::ifstream ipf(IP_FILE); std::getline(ipf,line); // header
+    std::vector<uint32_t> ips; ips.reserve(1<<20);
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    while(std::getline(ipf,line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss,ip_s,',')) continue;
+        std::getline(ss,dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+    double ip_load_s = secs_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1>rssC0? rssC1-rssC0:0);
+
+    // Phase D: lookup
+    auto tD0 = now();
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        auto* k = trie.lpm(ips[i]);
+        if(write_hex) results.emplace_back(ip_strs[i], k? bytes_to_hex(*k) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], k? std::string("1") : std::string("-1"));
+    }
+    double lookup_s = secs_since(tD0);
+
+    // Write matches
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r: results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // Metrics
+    double ns_per_lookup = ips.empty()?0.0 : (lookup_s*1e9/double(ips.size()));
+    double lookups_per_s = (lookup_s>0.0)? (double(ips.size())/lookup_s) : 0.0;
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(current_rss_bytes());
+
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "fill_factor,root_branch,trie_nodes,lc_struct_mb\n";
+    }
+    res<< "LC-Trie" << ','
+       << PREFIX_FILE << ','
+       << IP_FILE << ','
+       << num_prefixes << ','
+       << ips.size() << ','
+       << std::fixed << std::setprecision(6)
+       << prefix_load_s << ','
+       << build_ds_s << ','
+       << ip_load_s << ','
+       << lookup_s << ','
+       << std::setprecision(2)
+       << lookups_per_s << ','
+       << ns_per_lookup << ','
+       << std::setprecision(2)
+       << mem_prefix_array_mb << ','
+       << mem_ds_mb << ','
+       << mem_ip_array_mb << ','
+       << mem_total_mb << ','
+       << fill_factor << ','
+       << root_branch << ','
+       << trie.node_count() << ','
+       << std::setprecision(4) << bytes_to_mb(trie.bytes()) << '\n';
+
+    // Optional multithreaded scaling run (--threads N)
+    if(threads>0)
+        mt::run_threads_benchmark("LC-Trie", ips, threads, [&](uint32_t ip){ return trie.lpm(ip)!=nullptr; });
+
+    return 0;
+}
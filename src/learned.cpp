@@ -0,0 +1,320 @@
+// src/learned.cpp
+// Learned-index LPM: PGM-style piecewise-linear models over interval starts.
+//
+// The prefix table is flattened into disjoint address ranges, each carrying the
+// key id of its longest matching prefix. Instead of a search tree, a hierarchy
+// of linear segments predicts where an address falls in the sorted range
+// starts, within a fixed error bound eps; a short binary search over the
+// 2*eps+3 neighbouring starts (a cache line or two) finishes the lookup.
+// For large, mostly static tables the model is only a few KB.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include "mt_lookup.h"
+#include "range_build.h"
+
+// ---------------- Paths ----------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_learned.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_learned.csv";
+
+// ---------------- Utils ----------------
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t){ return std::chrono::duration<double>(now()-t).count(); }
+
+static inline size_t rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size(); i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
+    std::ostringstream oss;
+    for(int i=0;i<len;++i) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(key[i]);
+    return oss.str();
+}
+
+// ---------------- Key pool (dedup, id-indexed) ----------------
+// key id 0 is reserved for "no match"
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t*> g_keys(1, nullptr);
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
+    std::vector<uint8_t> tmp = hex_to_bytes(hex);
+    if(tmp.size() != 64) return 0;
+    uint8_t* p = new uint8_t[64];
+    std::memcpy(p, tmp.data(), 64);
+    uint32_t id = uint32_t(g_keys.size());
+    g_keys.push_back(p);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ---------------- Piecewise-linear learned index ----------------
+// A segment predicts the position of key x as pos + slope * (x - key) and is
+// built so that every key it covers is predicted within +-eps of its index
+// (greedy shrinking cone). Level 0 indexes the sorted range starts; level l+1
+// indexes the first keys of level l's segments, up to a single root segment.
+struct Segment{ uint32_t key; uint32_t pos; double slope; };
+
+static std::vector<Segment> fit_segments(const std::vector<uint32_t>& keys, uint32_t eps){
+    std::vector<Segment> segs;
+    size_t i = 0, n = keys.size();
+    while(i < n){
+        uint32_t x0 = keys[i], y0 = uint32_t(i);
+        double lo = -1e300, hi = 1e300;
+        size_t j = i + 1;
+        for(; j < n; ++j){
+            double dx = double(keys[j] - x0), dy = double(j - i);
+            double l = (dy - eps) / dx, h = (dy + eps) / dx;
+            if(std::max(lo, l) > std::min(hi, h)) break;
+            lo = std::max(lo, l); hi = std::min(hi, h);
+        }
+        double slope = (j == i + 1) ? 0.0 : (lo + hi) / 2;
+        segs.push_back({x0, y0, slope});
+        i = j;
+    }
+    return segs;
+}
+
+struct LearnedIndex {
+    uint32_t eps = 16;
+    std::vector<uint32_t> starts;                 // sorted range starts
+    std::vector<uint32_t> key_ids;                // key id of range i
+    std::vector<std::vector<Segment>> levels;     // levels[0] indexes starts
+    std::vector<std::vector<uint32_t>> level_keys;// first keys of levels[l] (searched from l+1)
+    uint32_t max_err = 0;                         // measured over all starts, level 0
+
+    void build(const std::vector<Range>& ranges, uint32_t e){
+        eps = e;
+        for(const auto& r : ranges){ starts.push_back(r.start); key_ids.push_back(r.key_id); }
+
+        levels.push_back(fit_segments(starts, eps));
+        while(levels.back().size() > 1){
+            std::vector<uint32_t> k; k.reserve(levels.back().size());
+            for(const auto& s : levels.back()) k.push_back(s.key);
+            level_keys.push_back(k);
+            levels.push_back(fit_segments(k, eps));
+        }
+
+        for(size_t i=0;i<starts.size();++i){
+            uint32_t s = seg_of(levels[0], starts[i]);
+            uint32_t p = predict(levels[0], s, starts[i], uint32_t(starts.size()));
+            max_err = std::max(max_err, p > i ? uint32_t(p - i) : uint32_t(i - p));
+        }
+    }
+
+    // segment covering x (build time only; lookups predict it from the level above)
+    static uint32_t seg_of(const std::vector<Segment>& segs, uint32_t x){
+        size_t lo = 0, hi = segs.size() - 1;
+        while(lo < hi){ size_t mid = (lo + hi + 1) / 2; if(segs[mid].key <= x) lo = mid; else hi = mid - 1; }
+        return uint32_t(lo);
+    }
+
+    // predicted index of x in the array indexed by segs, clamped to segment s
+    static inline uint32_t predict(const std::vector<Segment>& segs, uint32_t s, uint32_t x, uint32_t n){
+        const Segment& g = segs[s];
+        uint32_t last = (s + 1 < segs.size()) ? segs[s+1].pos - 1 : n - 1;
+        double p = double(g.pos) + g.slope * double(x - g.key);
+        if(p <= double(g.pos)) return g.pos;
+        if(p >= double(last))  return last;
+        return uint32_t(p);
+    }
+
+    // last index in [p-eps-1, p+eps+1] with a[i] <= x (a[0] <= x always)
+    inline uint32_t last_mile(const uint32_t* a, uint32_t n, uint32_t p, uint32_t x) const {
+        uint32_t lo = p > eps + 1 ? p - eps - 1 : 0;
+        uint32_t hi = std::min(n - 1, p + eps + 1);
+        while(lo < hi){
+            uint32_t mid = (lo + hi + 1) >> 1;
+            if(a[mid] <= x) lo = mid; else hi = mid - 1;
+        }
+        // the window always holds the answer; these only guard rounding
+        while(lo > 0 && a[lo] > x) --lo;
+        while(lo + 1 < n && a[lo+1] <= x) ++lo;
+        return lo;
+    }
+
+    inline uint32_t lookup(uint32_t ip) const {
+        uint32_t s = 0;   // root segment
+        for(size_t l = levels.size() - 1; l > 0; --l){
+            const auto& k = level_keys[l-1];
+            uint32_t p = predict(levels[l], s, ip, uint32_t(k.size()));
+            s = last_mile(k.data(), uint32_t(k.size()), p, ip);
+        }
+        uint32_t p = predict(levels[0], s, ip, uint32_t(starts.size()));
+        return key_ids[last_mile(starts.data(), uint32_t(starts.size()), p, ip)];
+    }
+
+    size_t model_bytes() const {
+        size_t b = 0;
+        for(const auto& lv : levels) b += lv.size() * sizeof(Segment);
+        for(const auto& k : level_keys) b += k.size() * sizeof(uint32_t);
+        return b;
+    }
+    size_t data_bytes() const { return (starts.size() + key_ids.size()) * sizeof(uint32_t); }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    int threads = 0;
+    int eps = 16;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if((a=="-e"||a=="--eps") && i+1<argc) eps = std::stoi(argv[++i]);
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-e eps] [--threads N]\n"
+                       "  -chk   Write hex keys to match file (slower)\n"
+                       "  -e     Model error bound in positions (default 16)\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+    if(eps < 1){ std::cerr<<"Error: eps must be >= 1\n"; return 1; }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0=now(); size_t rA0=rss_bytes();
+
+    std::vector<PRec> prefixes; prefixes.reserve(200000);
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf, line); // header "prefix,key"
+
+    size_t num_prefixes=0;
+    while(std::getline(pf, line)){
+        std::istringstream ss(line);
+        std::string pfx, khex;
+        if(!std::getline(ss, pfx, ',')) continue;
+        if(!std::getline(ss, khex)) continue;
+
+        auto slash = pfx.find('/');
+        if(slash == std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0, slash));
+        uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
+
+        prefixes.push_back({net, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    double mem_prefix_mb = to_mb(rss_bytes() - rA0);
+
+    // -------- Phase B: Fit learned index --------
+    auto tB0=now(); size_t rB0=rss_bytes();
+
+    LearnedIndex li;
+    li.build(build_ranges(prefixes), uint32_t(eps));
+
+    double build_ds_s = secs_since(tB0);
+    double mem_ds_mb  = to_mb(rss_bytes() - rB0);
+
+    prefixes.clear(); prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rC0=rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header "ip,used_prefix"
+
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    std::vector<uint32_t>    ips;     ips.reserve(1<<20);
+
+    while(std::getline(ipf, line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss, ip_s, ',')) continue;
+        std::getline(ss, dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    double mem_ip_mb = to_mb(rss_bytes() - rC0);
+
+    // -------- Phase D: Lookup --------
+    auto tD0=now();
+
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint8_t* key = g_keys[li.lookup(ips[i])];
+        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
+    }
+
+    double lookup_s = secs_since(tD0);
+    double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write match file --------
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r : results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // -------- Metrics CSV (MB) --------
+    double mem_total_mb = to_mb(rss_bytes());
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+              "eps,num_ranges,num_segments,model_levels,model_kb,max_err,data_mb\n";
+    }
+    res<<"PGM-eps"<<eps<<','
+       <<PREFIX_FILE<<','<<IP_FILE<<','
+       <<num_prefixes<<','<<ips.size()<<','
+       <<std::fixed<<std::setprecision(6)
+       <<prefix_load_s<<','<<build_ds_s<<','<<ip_load_s<<','<<lookup_s<<','
+       <<std::setprecision(2)
+       <<lookups_per_s<<','<<ns_per_lookup<<','
+       <<std::setprecision(2)
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<','
+       <<eps<<','<<li.starts.size()<<','<<li.levels[0].size()<<','<<li.levels.size()<<','
+       <<double(li.model_bytes())/1024.0<<','<<li.max_err<<','
+       <<std::setprecision(4)<<to_mb(li.data_bytes())<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark("PGM-eps" + std::to_string(eps), ips, threads, [&](uint32_t ip){ return li.lookup(ip)!=0; });
+
+    // -------- Cleanup (keys) --------
+    for(auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
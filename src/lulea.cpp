@@ -0,0 +1,564 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+#include <unistd.h>   // sysconf
+#include "mt_lookup.h"
+
+// Lulea compressed trie (Degermark et al., "Small Forwarding Tables for Fast
+// Routing Lookups"), 16/8/8 levels.
+//
+// Each level is the leaf-pushed prefix tree cut at its depth. A bit vector
+// marks the heads (first slot) of maximal aligned runs; it is never stored,
+// only its 16-bit masks through codewords: a 10-bit maptable index plus a
+// 6-bit count of heads since the last base index. Because the heads in a
+// mask form a cut of a complete binary tree, only 677 non-empty masks exist,
+// and the maptable gives the rank of any slot inside any of them.
+//
+// Level 2/3 chunks (256 slots) come in three flavours by head count:
+//   sparse     (1..8)   head positions searched directly
+//   dense      (9..63)  16 codewords, no base index
+//   very dense (64+)    16 codewords + 4 base indexes, like level 1
+// A pointer is either a key id or a typed chunk reference.
+
+// ------------------------- Config / constants -------------------------
+static const int L1_BITS    = 16;
+static const int L1_SLOTS   = 1 << L1_BITS;
+static const int CHUNK_BITS = 8;
+static const int CHUNK_SLOTS = 1 << CHUNK_BITS;
+
+static const uint32_t PTR_KEY     = 0u << 30;
+static const uint32_t PTR_SPARSE  = 1u << 30;
+static const uint32_t PTR_DENSE   = 2u << 30;
+static const uint32_t PTR_VDENSE  = 3u << 30;
+static const uint32_t PTR_TYPE    = 3u << 30;
+static const uint32_t PTR_INDEX   = ~PTR_TYPE;
+
+// File paths (relative to repo root)
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_lulea.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_lulea.csv";
+
+// ------------------------- Memory / timing helpers --------------------
+size_t current_rss_bytes() {
+    // Linux: /proc/self/statm (resident pages * page size)
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+inline auto now() {
+    return std::chrono::high_resolution_clock::now();
+}
+inline double seconds_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+inline double bytes_to_mb(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// ------------------------- Utilities ---------------------------------
+uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+std::string bytes_to_hex(const uint8_t* key, int len = 64) {
+    std::ostringstream oss;
+    for (int i = 0; i < len; ++i) {
+        oss << std::hex << std::setw(2) << std::setfill('0')
+            << static_cast<int>(key[i]);
+    }
+    return oss.str();
+}
+bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+
+// ------------------------- Data structures ---------------------------
+struct PrefixRec {
+    uint32_t base_ip;  // aligned network address
+    uint8_t  len;      // prefix length
+    uint32_t key_id;   // index into g_keys (0 = no key)
+};
+std::unordered_map<std::string, uint32_t> g_key_ids;
+std::vector<uint8_t*> g_keys(1, nullptr);
+
+// Maptable: maptable[r][i] = number of heads in mask r at slots 0..i
+std::vector<uint16_t> g_masks;                 // mask r (bit 15 = slot 0)
+std::unordered_map<uint16_t, uint16_t> g_mask_index;
+std::vector<std::array<uint8_t, 16>> maptable;
+
+// Level 1
+uint16_t l1_code[L1_SLOTS / 16];               // (maptable index << 6) | six
+uint16_t l1_base[L1_SLOTS / 64];               // heads before each group of 4 codewords
+std::vector<uint32_t> l1_ptr;
+
+// Levels 2 and 3
+struct SparseChunk { uint8_t n; uint8_t heads[8]; uint32_t ptr_base; };
+struct DenseChunk  { uint16_t code[16]; uint32_t ptr_base; };
+struct VDenseChunk { uint16_t code[16]; uint16_t base[4]; uint32_t ptr_base; };
+std::vector<SparseChunk> sparse_chunks;
+std::vector<DenseChunk>  dense_chunks;
+std::vector<VDenseChunk> vdense_chunks;
+std::vector<uint32_t>    chunk_ptr;
+
+// Build-time binary trie
+struct TrieNode { int32_t child[2]{-1, -1}; uint32_t key_id = 0; };
+std::vector<TrieNode> g_trie;
+
+// ------------------------- Key handling -------------------------------
+uint32_t get_or_create_key_id(const std::string& hex) {
+    if (hex.size() != 128) return 0;
+    auto it = g_key_ids.find(hex);
+    if (it != g_key_ids.end()) return it->second;
+
+    uint8_t* bytes = new uint8_t[64];
+    for (size_t i = 0; i < 128; i += 2) {
+        bytes[i/2] = static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    uint32_t id = static_cast<uint32_t>(g_keys.size());
+    g_keys.push_back(bytes);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ------------------------- Maptable ----------------------------------
+// All head patterns of a complete binary tree over 2^h slots: a single leaf,
+// or a left pattern followed by a right pattern.
+static std::vector<uint16_t> tree_masks(int h) {
+    int width = 1 << h;
+    std::vector<uint16_t> out;
+    out.push_back(uint16_t(1u << (width - 1)));
+    if (h > 0) {
+        std::vector<uint16_t> sub = tree_masks(h - 1);
+        for (uint16_t l : sub)
+            for (uint16_t r : sub)
+                out.push_back(uint16_t((l << (width / 2)) | r));
+    }
+    return out;
+}
+
+void build_maptable() {
+    g_masks = tree_masks(4);                    // 677 patterns
+    g_masks.push_back(0);                       // mask fully covered by an earlier head
+    for (size_t r = 0; r < g_masks.size(); ++r) {
+        g_mask_index[g_masks[r]] = uint16_t(r);
+        std::array<uint8_t, 16> row{};
+        uint8_t cnt = 0;
+        for (int i = 0; i < 16; ++i) {
+            if (g_masks[r] & (1u << (15 - i))) ++cnt;
+            row[i] = cnt;
+        }
+        maptable.push_back(row);
+    }
+}
+
+// ------------------------- Build --------------------------------------
+void trie_insert(uint32_t ip, uint8_t len, uint32_t key_id) {
+    int32_t n = 0;
+    for (int i = 0; i < len; ++i) {
+        int bit = (ip >> (31 - i)) & 1;
+        if (g_trie[n].child[bit] < 0) {
+            g_trie[n].child[bit] = int32_t(g_trie.size());
+            g_trie.push_back(TrieNode{});
+        }
+        n = g_trie[n].child[bit];
+    }
+    g_trie[n].key_id = key_id;
+}
+
+// Leaf-pushed value of a slot: a key id, or a subtree that continues below.
+struct Slot {
+    uint32_t key_id;
+    int32_t  node;     // trie node with descendants, -1 for a plain key
+    bool operator==(const Slot& o) const { return node < 0 && o.node < 0 && key_id == o.key_id; }
+};
+
+// Expand trie node n (at the top of a 2^bits slot block) into slots[lo, lo+size).
+void expand(int32_t n, uint32_t best, std::vector<Slot>& slots, uint32_t lo, uint32_t size) {
+    if (n < 0) {
+        std::fill(slots.begin() + lo, slots.begin() + lo + size, Slot{best, -1});
+        return;
+    }
+    const TrieNode& t = g_trie[n];
+    if (t.key_id) best = t.key_id;
+    bool leaf = t.child[0] < 0 && t.child[1] < 0;
+    if (size == 1) {
+        slots[lo] = Slot{best, leaf ? -1 : n};
+        return;
+    }
+    if (leaf) {
+        std::fill(slots.begin() + lo, slots.begin() + lo + size, Slot{best, -1});
+        return;
+    }
+    expand(t.child[0], best, slots, lo, size / 2);
+    expand(t.child[1], best, slots, lo + size / 2, size / 2);
+}
+
+// Heads are the starts of maximal aligned uniform blocks.
+void mark_heads(const std::vector<Slot>& slots, uint32_t lo, uint32_t size, std::vector<uint32_t>& heads) {
+    bool uniform = true;
+    for (uint32_t i = lo + 1; i < lo + size && uniform; ++i) uniform = (slots[i] == slots[lo]);
+    if (uniform) { heads.push_back(lo); return; }
+    mark_heads(slots, lo, size / 2, heads);
+    mark_heads(slots, lo + size / 2, size / 2, heads);
+}
+
+uint16_t mask_of(const std::vector<uint8_t>& is_head, uint32_t m) {
+    uint16_t mask = 0;
+    for (int i = 0; i < 16; ++i) if (is_head[m * 16 + i]) mask |= uint16_t(1u << (15 - i));
+    return mask;
+}
+
+uint32_t make_pointer(const Slot& s, int depth);
+
+// Build a level-2/3 chunk for a subtree rooted at `depth`.
+uint32_t make_chunk(int32_t node, uint32_t best, int depth) {
+    std::vector<Slot> slots(CHUNK_SLOTS);
+    expand(node, best, slots, 0, CHUNK_SLOTS);
+    std::vector<uint32_t> heads;
+    mark_heads(slots, 0, CHUNK_SLOTS, heads);
+
+    // Reserve the pointer block first; sub-chunks append after it.
+    uint32_t ptr_base = uint32_t(chunk_ptr.size());
+    chunk_ptr.resize(chunk_ptr.size() + heads.size());
+    for (size_t h = 0; h < heads.size(); ++h) {
+        uint32_t p = make_pointer(slots[heads[h]], depth + CHUNK_BITS);
+        chunk_ptr[ptr_base + h] = p;
+    }
+
+    if (heads.size() <= 8) {
+        SparseChunk c{};
+        c.n = uint8_t(heads.size());
+        for (size_t h = 0; h < heads.size(); ++h) c.heads[h] = uint8_t(heads[h]);
+        c.ptr_base = ptr_base;
+        sparse_chunks.push_back(c);
+        return PTR_SPARSE | uint32_t(sparse_chunks.size() - 1);
+    }
+
+    std::vector<uint8_t> is_head(CHUNK_SLOTS, 0);
+    for (uint32_t h : heads) is_head[h] = 1;
+    uint16_t code[16], base[4];
+    uint32_t seen = 0;
+    bool very_dense = heads.size() >= 64;   // keeps `six` within 6 bits
+    for (uint32_t m = 0; m < 16; ++m) {
+        if (very_dense && (m & 3) == 0) base[m >> 2] = uint16_t(seen);
+        uint16_t mask = mask_of(is_head, m);
+        uint32_t six = very_dense ? seen - base[m >> 2] : seen;
+        code[m] = uint16_t((g_mask_index.at(mask) << 6) | six);
+        seen += uint32_t(__builtin_popcount(mask));
+    }
+    if (!very_dense) {
+        DenseChunk c{};
+        std::memcpy(c.code, code, sizeof(code));
+        c.ptr_base = ptr_base;
+        dense_chunks.push_back(c);
+        return PTR_DENSE | uint32_t(dense_chunks.size() - 1);
+    }
+    VDenseChunk c{};
+    std::memcpy(c.code, code, sizeof(code));
+    std::memcpy(c.base, base, sizeof(base));
+    c.ptr_base = ptr_base;
+    vdense_chunks.push_back(c);
+    return PTR_VDENSE | uint32_t(vdense_chunks.size() - 1);
+}
+
+uint32_t make_pointer(const Slot& s, int depth) {
+    if (s.node < 0) return PTR_KEY | s.key_id;
+    return make_chunk(s.node, s.key_id, depth);
+}
+
+void build_lulea(const std::vector<PrefixRec>& prefixes) {
+    build_maptable();
+
+    g_trie.assign(1, TrieNode{});
+    for (const auto& rec : prefixes) trie_insert(rec.base_ip, rec.len, rec.key_id);
+
+    std::vector<Slot> slots(L1_SLOTS);
+    expand(0, 0, slots, 0, L1_SLOTS);
+    std::vector<uint32_t> heads;
+    mark_heads(slots, 0, L1_SLOTS, heads);
+
+    std::vector<uint8_t> is_head(L1_SLOTS, 0);
+    for (uint32_t h : heads) is_head[h] = 1;
+    uint32_t seen = 0;
+    for (uint32_t m = 0; m < L1_SLOTS / 16; ++m) {
+        if ((m & 3) == 0) l1_base[m >> 2] = uint16_t(seen);
+        uint16_t mask = mask_of(is_head, m);
+        l1_code[m] = uint16_t((g_mask_index.at(mask) << 6) | (seen - l1_base[m >> 2]));
+        seen += uint32_t(__builtin_popcount(mask));
+    }
+
+    l1_ptr.resize(heads.size());
+    for (size_t h = 0; h < heads.size(); ++h) l1_ptr[h] = make_pointer(slots[heads[h]], L1_BITS);
+
+    g_trie.clear();
+    g_trie.shrink_to_fit();
+}
+
+size_t lulea_bytes() {
+    return sizeof(l1_code) + sizeof(l1_base)
+         + l1_ptr.size() * sizeof(uint32_t)
+         + sparse_chunks.size() * sizeof(SparseChunk)
+         + dense_chunks.size() * sizeof(DenseChunk)
+         + vdense_chunks.size() * sizeof(VDenseChunk)
+         + chunk_ptr.size() * sizeof(uint32_t)
+         + maptable.size() * sizeof(maptable[0]);
+}
+
+// ------------------------- Lookup -------------------------------------
+inline uint32_t codeword_rank(uint16_t code, uint32_t bit) {
+    return uint32_t(code & 63) + maptable[code >> 6][bit];
+}
+
+inline uint32_t lulea_lookup(uint32_t ip) {
+    uint32_t ix  = ip >> 20;
+    uint32_t bit = (ip >> 16) & 15;
+    uint32_t p = l1_ptr[l1_base[ix >> 2] + codeword_rank(l1_code[ix], bit) - 1];
+
+    int shift = 32 - L1_BITS - CHUNK_BITS;
+    while (p & PTR_TYPE) {
+        uint32_t pos = (ip >> shift) & 0xFF;
+        uint32_t idx = p & PTR_INDEX;
+        switch (p & PTR_TYPE) {
+            case PTR_SPARSE: {
+                const SparseChunk& c = sparse_chunks[idx];
+                uint32_t r = 0;
+                for (uint32_t h = 0; h < c.n; ++h) r += (c.heads[h] <= pos);
+                p = chunk_ptr[c.ptr_base + r - 1];
+                break;
+            }
+            case PTR_DENSE: {
+                const DenseChunk& c = dense_chunks[idx];
+                p = chunk_ptr[c.ptr_base + codeword_rank(c.code[pos >> 4], pos & 15) - 1];
+                break;
+            }
+            default: {
+                const VDenseChunk& c = vdense_chunks[idx];
+                p = chunk_ptr[c.ptr_base + c.base[pos >> 6] + codeword_rank(c.code[pos >> 4], pos & 15) - 1];
+                break;
+            }
+        }
+        shift -= CHUNK_BITS;
+    }
+    return p;
+}
+
+// ------------------------- Main --------------------------------------
+int main(int argc, char* argv[]) {
+    // Check for -chk flag to output hex keys
+    bool write_hex = false;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-chk" || arg == "--chk") {
+            write_hex = true;
+        } else if ((arg == "-threads" || arg == "--threads") && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [-chk] [--threads N]\n"
+                      << "  -chk          Write hex keys to match file (slower)\n"
+                      << "  --threads N   Also measure lookup scaling on N pinned threads\n"
+                      << "                (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // ----------------- Phase A: Load Prefixes (batch) -----------------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream fib(PREFIX_FILE);
+    std::string line;
+    std::getline(fib, line); // skip header "prefix,key"
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000); // guess; adjust as needed
+
+    size_t num_prefixes = 0;
+    while (std::getline(fib, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',')) continue;
+        if (!std::getline(ss, key_hex)) continue;
+
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        if (len > 32) continue;  // Skip invalid prefix lengths
+        uint32_t base_ip = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(key_hex);
+        if (!key_id) continue;
+        prefixes.push_back({base_ip, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = seconds_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // ----------------- Phase B: Build DS (Lulea) ----------------------
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+
+    build_lulea(prefixes);
+
+    double build_ds_s = seconds_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+
+    // Optional: free prefix array to observe DS-only memory
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    // ----------------- Phase C: Load IPs (batch) ----------------------
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipfile(IP_FILE);
+    std::getline(ipfile, line); // skip header "ip,used_prefix"
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1000000); ip_strs.reserve(1000000); // guess; adjust as needed
+
+    while (std::getline(ipfile, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, discard;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, discard); // used_prefix (ignored for speed)
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = seconds_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // ----------------- Phase D: Lookup -------------------------------
+    auto tD0 = now();
+
+    std::vector<std::string> results;
+    results.reserve(ips.size());
+
+    for (uint32_t ip : ips) {
+        uint8_t* key = g_keys[lulea_lookup(ip)];
+        if (write_hex) {
+            results.emplace_back(key ? bytes_to_hex(key) : "-1");
+        } else {
+            results.emplace_back(key ? "1" : "-1");
+        }
+    }
+
+    double lookup_time_s = seconds_since(tD0);
+    double ns_per_lookup = (ips.empty() ? 0.0 : (lookup_time_s * 1e9 / static_cast<double>(ips.size())));
+    double lookups_per_s = (lookup_time_s > 0.0 ? (static_cast<double>(ips.size()) / lookup_time_s) : 0.0);
+
+    // ----------------- Output matches -------------------------------
+    {
+        std::ofstream out(MATCH_FILE);
+        if (!out.is_open()) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (size_t i = 0; i < ips.size(); ++i) {
+                out << ip_strs[i] << "," << results[i] << "\n";
+            }
+        }
+    }
+
+    // ----------------- Final memory totals --------------------------
+    size_t rss_total_bytes = current_rss_bytes();
+
+    // Convert memory to MB for output
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(rss_total_bytes);
+
+    // ----------------- Append metrics CSV ---------------------------
+    // Columns:
+    // algorithm,prefix_file,ip_file,num_prefixes,num_ips,
+    // prefix_load_s,build_ds_s,ip_load_s,lookup_s,lookups_per_s,ns_per_lookup,
+    // mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,
+    // l1_heads,sparse_chunks,dense_chunks,vdense_chunks,lulea_struct_kb
+    const char* algo_name = "Lulea";
+
+    bool write_header = !file_exists(RESULTS_FILE);
+    std::ofstream r(RESULTS_FILE, std::ios::app);
+    if (!r.is_open()) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        r.setf(std::ios::fixed);
+        if (write_header) {
+            r << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                 "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                 "lookups_per_s,ns_per_lookup,"
+                 "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+                 "l1_heads,sparse_chunks,dense_chunks,vdense_chunks,lulea_struct_kb\n";
+        }
+        r << algo_name << ","
+          << PREFIX_FILE << ","
+          << IP_FILE << ","
+          << num_prefixes << ","
+          << ips.size() << ","
+          << std::setprecision(6)
+          << prefix_load_s << ","
+          << build_ds_s << ","
+          << ip_load_s << ","
+          << lookup_time_s << ","
+          << std::setprecision(2) << lookups_per_s << ","
+          << std::setprecision(2) << ns_per_lookup << ","
+          << std::setprecision(2)
+          << mem_prefix_array_mb << ","
+          << mem_ds_mb << ","
+          << mem_ip_array_mb << ","
+          << mem_total_mb << ","
+          << l1_ptr.size() << ","
+          << sparse_chunks.size() << ","
+          << dense_chunks.size() << ","
+          << vdense_chunks.size() << ","
+          << lulea_bytes() / 1024.0
+          << "\n";
+    }
+
+    // ----------------- Optional: multithreaded scaling run ---------
+    if (threads > 0)
+        mt::run_threads_benchmark(algo_name, ips, threads,
+                                  [](uint32_t ip) { return lulea_lookup(ip) != 0; });
+
+    // ----------------- Cleanup -------------------------------------
+    for (auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
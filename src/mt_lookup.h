@@ -0,0 +1,152 @@
+// mt_lookup.h -- shared multithreaded lookup driver for the engines' --threads mode.
+//
+// Every engine keeps its single-threaded Phase D. With --threads N it also calls
+// run_threads_benchmark() with a lookup callback. The driver splits the IP
+// array into one contiguous chunk per thread and pins each thread to its own
+// CPU with pthread_setaffinity_np. All threads then start together against
+// the same read-only table. Each thread counts into a cache-line-padded slot,
+// so the counters never false-share.
+//
+// A 1-thread pass runs first as the baseline, then the N-thread pass. Rows are
+// appended to benchmarks/results_threads.csv: one per thread, plus one "all"
+// row per pass with the aggregate rate. On "all" rows scaling_efficiency is
+// lookups_per_s / (threads * single-thread lookups_per_s). On per-thread rows
+// it is that thread's rate divided by the single-thread rate. When it drops
+// as N grows, the table has hit a shared limit (memory bandwidth, LLC, SMT
+// siblings).
+//
+// The callback must be safe to call concurrently and return something
+// truthy for a match; matches are summed so the lookups cannot be optimized
+// away. glibc >= 2.34 needs no extra flag; older toolchains need -pthread.
+#pragma once
+
+#include <pthread.h>
+#include <sched.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mt {
+
+static const char*    THREADS_FILE = "benchmarks/results_threads.csv";
+static const uint64_t MIN_LOOKUPS  = 1ull << 22;  // repeat the IP array until each pass does this many
+
+struct alignas(64) ThreadStat {
+    uint64_t lookups = 0;
+    uint64_t hits    = 0;
+    double   secs    = 0.0;
+    int      cpu     = -1;   // -1 = not pinned
+};
+
+// CPUs this process may run on (honours taskset / cgroup cpusets).
+inline std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (int c = 0; c < CPU_SETSIZE; ++c)
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+    return cpus;
+}
+
+inline bool pin_to_cpu(int cpu) {
+    if (cpu < 0) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+// One timed pass with `threads` workers. Thread t gets chunk t of the IP array
+// and walks it `reps` times. It is pinned to allowed CPU t (wrapping if
+// there are more threads than CPUs). Returns wall time from release to the
+// last join.
+template <class IP, class Fn>
+double run_pass(const std::vector<IP>& ips, int threads, uint64_t reps, Fn& lookup,
+                std::vector<ThreadStat>& stats) {
+    const std::vector<int> cpus = allowed_cpus();
+    const size_t n = ips.size();
+    const size_t chunk = (n + threads - 1) / threads;
+    stats.assign(threads, ThreadStat{});
+
+    std::atomic<int>  ready{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> pool;
+    pool.reserve(threads);
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            ThreadStat& s = stats[t];
+            int cpu = cpus.empty() ? -1 : cpus[t % cpus.size()];
+            s.cpu = pin_to_cpu(cpu) ? cpu : -1;
+            const size_t b = std::min(n, size_t(t) * chunk);
+            const size_t e = std::min(n, b + chunk);
+            ready.fetch_add(1);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+
+            auto t0 = std::chrono::steady_clock::now();
+            for (uint64_t r = 0; r < reps; ++r)
+                for (size_t i = b; i < e; ++i) s.hits += lookup(ips[i]) ? 1 : 0;
+            s.secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            s.lookups = uint64_t(e - b) * reps;
+        });
+    }
+    while (ready.load() < threads) std::this_thread::yield();
+    auto t0 = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& th : pool) th.join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// Runs the 1-thread baseline and the N-thread pass, then appends their rows to
+// THREADS_FILE. Returns the aggregate N-thread lookups_per_s.
+template <class IP, class Fn>
+double run_threads_benchmark(const std::string& algo, const std::vector<IP>& ips, int threads, Fn lookup) {
+    if (ips.empty() || threads < 1) return 0.0;
+    const uint64_t reps = std::max<uint64_t>(1, (MIN_LOOKUPS + ips.size() - 1) / ips.size());
+
+    bool need_header = !std::ifstream(THREADS_FILE).good();
+    std::ofstream res(THREADS_FILE, std::ios::app);
+    if (!res) {
+        std::cerr << "Error: cannot open " << THREADS_FILE << " for writing\n";
+        return 0.0;
+    }
+    res.setf(std::ios::fixed);
+    if (need_header)
+        res << "algorithm,num_ips,threads,thread,cpu,lookups,lookup_s,"
+               "lookups_per_s,scaling_efficiency\n";
+
+    double base_lps = 0.0, agg_lps = 0.0;
+    std::vector<ThreadStat> stats;
+    auto measure = [&](int nt) {
+        double wall = run_pass(ips, nt, reps, lookup, stats);
+        uint64_t total = 0;
+        for (auto& s : stats) total += s.lookups;
+        agg_lps = wall > 0.0 ? double(total) / wall : 0.0;
+        if (nt == 1) base_lps = agg_lps;
+
+        for (int t = 0; t < nt; ++t) {
+            const ThreadStat& s = stats[t];
+            double lps = s.secs > 0.0 ? double(s.lookups) / s.secs : 0.0;
+            res << algo << ',' << ips.size() << ',' << nt << ',' << t << ',' << s.cpu << ','
+                << s.lookups << ',' << std::setprecision(6) << s.secs << ','
+                << std::setprecision(2) << lps << ','
+                << std::setprecision(4) << (base_lps > 0.0 ? lps / base_lps : 0.0) << '\n';
+        }
+        res << algo << ',' << ips.size() << ',' << nt << ",all,-1,"
+            << total << ',' << std::setprecision(6) << wall << ','
+            << std::setprecision(2) << agg_lps << ','
+            << std::setprecision(4) << (base_lps > 0.0 ? agg_lps / (nt * base_lps) : 0.0) << '\n';
+    };
+    measure(1);
+    if (threads > 1) measure(threads);
+    return agg_lps;
+}
+
+} // namespace mt
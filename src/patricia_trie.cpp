@@ -9,11 +9,24 @@
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstdint>
+#include <algorithm>
+#include <cctype>
+#include "mt_lookup.h"
+#if defined(__cpp_impl_coroutine)
+#include <coroutine>
+#include <exception>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>   // AVX2 lockstep walker (target attribute)
+#define HAVE_X86_KERNELS 1
+#endif
 
 static const char* PREFIX_FILE   = "data/prefix_table.csv";
 static const char* IP_FILE       = "data/generated_ips.csv";
 static const char* MATCH_FILE    = "benchmarks/match_pat.csv";
 static const char* RESULTS_FILE  = "benchmarks/results_pat.csv";
+static const size_t CORO_WIDTH   = 16;     // default lookups in flight for -coro
+static const int    CORO_HOT_STEPS = 8;    // first steps hit cache-resident nodes; no yield there
 
 static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
 static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
@@ -48,6 +61,46 @@ struct PatriciaNode {
     PatriciaNode* right = nullptr;
 };
 
+// Index-based node for the lockstep walker (BFS order, 32 bytes). Node 0 is a
+// null sentinel that retired lanes keep gathering from. key_id 0 = no key.
+// Leaves keep bit_index 0; their children are 0 anyway.
+struct FlatNode {
+    uint32_t child[2];
+    uint32_t key_id;
+    uint32_t bit_index;
+    uint32_t prefix;
+    uint32_t mask;
+    uint32_t pad[2];
+};
+
+#if defined(__cpp_impl_coroutine)
+// A lookup that suspends after prefetching each node it is about to visit.
+// Frames are all the same size and are recycled through a free list.
+struct LpmTask {
+    struct promise_type {
+        const std::vector<uint8_t>* result = nullptr;
+        LpmTask get_return_object(){ return LpmTask{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_value(const std::vector<uint8_t>* r){ result = r; }
+        void unhandled_exception(){ std::terminate(); }
+
+        struct FreeFrame { FreeFrame* next; };
+        static inline FreeFrame* free_list = nullptr;
+        static inline size_t frame_size = 0;
+        static void* operator new(size_t n){
+            if(free_list && n==frame_size){ FreeFrame* f=free_list; free_list=f->next; return f; }
+            frame_size = n; return ::operator new(n);
+        }
+        static void operator delete(void* p, size_t n){
+            if(n!=frame_size){ ::operator delete(p); return; }
+            auto* f = static_cast<FreeFrame*>(p); f->next = free_list; free_list = f;
+        }
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+#endif
+
 class PatriciaTrie {
 public:
     ~PatriciaTrie(){ destroy(root); }
@@ -71,6 +124,74 @@ public:
         return best;
     }
 
+#if defined(__cpp_impl_coroutine)
+    // lpm() with a prefetch + yield before each node past the first few.
+    LpmTask lpm_coro(uint32_t ip) const {
+        const std::vector<uint8_t>* best = nullptr;
+        const PatriciaNode* n = root;
+        for(int step=0; n; ++step){
+            if(step >= CORO_HOT_STEPS){ __builtin_prefetch(n); co_await std::suspend_always{}; }
+            if(n->has_key && match_prefix(ip, n->prefix, n->prefix_len))
+                best = &n->key;
+            if(n->bit_index == -1) break;
+            int bit = (ip >> (31 - n->bit_index)) & 1;
+            n = (bit==0)? n->left : n->right;
+        }
+        co_return best;
+    }
+
+    // AMAC-style scheduler: `width` lookups in flight, resumed round-robin.
+    void lpm_interleaved(const uint32_t* ips, size_t n, size_t width,
+                         const std::vector<uint8_t>** out) const {
+        struct Slot{ std::coroutine_handle<LpmTask::promise_type> h; size_t idx; };
+        std::vector<Slot> slots(std::max<size_t>(1, width));
+        size_t next=0, active=0;
+        for(auto& s: slots){
+            if(next==n){ s.h=nullptr; continue; }
+            s.idx=next; s.h=lpm_coro(ips[next++]).handle; ++active;
+        }
+        while(active){
+            for(auto& s: slots){
+                if(!s.h) continue;
+                s.h.resume();
+                if(!s.h.done()) continue;
+                out[s.idx] = s.h.promise().result;
+                s.h.destroy();
+                if(next<n){ s.idx=next; s.h=lpm_coro(ips[next++]).handle; }
+                else      { s.h=nullptr; --active; }
+            }
+        }
+    }
+#endif
+
+    // Flatten into `nodes` (sentinel at 0, root at 1, or 0 if the trie is empty)
+    // and `keys` (keys[key_id], keys[0] = nullptr). Returns the root index.
+    uint32_t export_flat(std::vector<FlatNode>& nodes, std::vector<const std::vector<uint8_t>*>& keys) const {
+        std::vector<const PatriciaNode*> order{nullptr};
+        nodes.assign(1, FlatNode{});
+        keys.assign(1, nullptr);
+        if(!root) return 0;
+        order.push_back(root); nodes.push_back(FlatNode{});
+        for(size_t i=1;i<order.size();++i){
+            const PatriciaNode* n = order[i];
+            FlatNode& f = nodes[i];
+            f.bit_index = n->bit_index < 0 ? 0 : uint32_t(n->bit_index);
+            if(n->has_key){
+                f.key_id = uint32_t(keys.size()); keys.push_back(&n->key);
+                f.mask = mask_from_len(n->prefix_len); f.prefix = n->prefix & f.mask;
+            }
+            if(n->bit_index == -1) continue;
+            const PatriciaNode* kids[2] = {n->left, n->right};
+            for(int b=0;b<2;++b){
+                if(!kids[b]) continue;
+                uint32_t idx = uint32_t(order.size());
+                order.push_back(kids[b]); nodes.push_back(FlatNode{});
+                nodes[i].child[b] = idx;   // re-index: push_back may have moved f
+            }
+        }
+        return 1;
+    }
+
 private:
     PatriciaNode* root = nullptr;
     size_t inserted_ = 0;
@@ -197,17 +318,78 @@ private:
     }
 };
 
+// ---------- Lockstep walker over the flat node array ----------
+// Scalar walk: fallback without AVX2, and the tail of each batch.
+static inline uint32_t lpm_flat(const FlatNode* nodes, uint32_t root, uint32_t ip){
+    uint32_t best = 0;
+    for(uint32_t cur=root; cur; ){
+        const FlatNode& f = nodes[cur];
+        if(f.key_id && (ip & f.mask)==f.prefix) best = f.key_id;
+        cur = f.child[(ip >> (31 - f.bit_index)) & 1];
+    }
+    return best;
+}
+static void lpm_flat_batch(const FlatNode* nodes, uint32_t root, const uint32_t* ips, size_t n, uint32_t* out){
+    for(size_t i=0;i<n;++i) out[i] = lpm_flat(nodes, root, ips[i]);
+}
+
+#ifdef HAVE_X86_KERNELS
+// 8 addresses per step. Lanes sit at different split bits, so each step
+// gathers bit_index, key_id, prefix and mask for the lane's node, then uses a
+// per-lane variable shift to pick the child. A lane retires on reaching the
+// sentinel. Gather indexes are signed 32-bit, which allows up to 2^28 nodes.
+__attribute__((target("avx2")))
+static void lpm_lockstep_avx2(const FlatNode* nodes, uint32_t root, const uint32_t* ips, size_t n, uint32_t* out){
+    const int* base = reinterpret_cast<const int*>(nodes);
+    const __m256i one = _mm256_set1_epi32(1), c31 = _mm256_set1_epi32(31), zero = _mm256_setzero_si256();
+    size_t i=0;
+    for(; i+8<=n; i+=8){
+        __m256i ip   = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ips+i));
+        __m256i cur  = _mm256_set1_epi32(int(root));
+        __m256i best = zero;
+        while(!_mm256_testz_si256(cur, cur)){
+            __m256i at  = _mm256_slli_epi32(cur, 3);
+            __m256i key = _mm256_i32gather_epi32(base, _mm256_add_epi32(at, _mm256_set1_epi32(2)), 4);
+            __m256i bi  = _mm256_i32gather_epi32(base, _mm256_add_epi32(at, _mm256_set1_epi32(3)), 4);
+            __m256i pfx = _mm256_i32gather_epi32(base, _mm256_add_epi32(at, _mm256_set1_epi32(4)), 4);
+            __m256i msk = _mm256_i32gather_epi32(base, _mm256_add_epi32(at, _mm256_set1_epi32(5)), 4);
+            __m256i hit = _mm256_andnot_si256(_mm256_cmpeq_epi32(key, zero),
+                                              _mm256_cmpeq_epi32(_mm256_and_si256(ip, msk), pfx));
+            best = _mm256_blendv_epi8(best, key, hit);
+            __m256i bit = _mm256_and_si256(_mm256_srlv_epi32(ip, _mm256_sub_epi32(c31, bi)), one);
+            cur = _mm256_i32gather_epi32(base, _mm256_add_epi32(at, bit), 4);
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out+i), best);
+    }
+    for(; i<n; ++i) out[i] = lpm_flat(nodes, root, ips[i]);
+}
+#endif
+
 // ---------- Batch & benchmark like your other programs ----------
 int main(int argc, char* argv[]){
     bool write_hex = false;
+    bool coro = false, simd = false; size_t coro_width = CORO_WIDTH; int threads = 0;
     for(int i=1;i<argc;++i){
         std::string a = argv[i];
         if(a=="-chk"||a=="--chk") write_hex=true;
+        else if(a=="-coro"||a=="--coro"){
+            coro=true;
+            if(i+1<argc && std::isdigit((unsigned char)argv[i+1][0])) coro_width = std::max(1, std::stoi(argv[++i]));
+        }
+        else if(a=="-simd"||a=="--simd") simd=true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
         else if(a=="-h"||a=="--help"){
-            std::cout<<"Usage: "<<argv[0]<<" [-chk]\n";
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [-coro [N] | -simd]\n"
+                       "  -coro [N]  Coroutine-interleaved lookups, N in flight (default "<<CORO_WIDTH<<"; needs -std=c++20)\n"
+                       "  -simd      AVX2 lockstep walk of 8 addresses over a flattened node array\n"
+                       "  --threads N  Also measure scalar lpm() scaling on N pinned threads (results_threads.csv)\n";
             return 0;
         }
     }
+    if(coro && simd){ std::cerr<<"Error: -coro and -simd are mutually exclusive\n"; return 1; }
+#if !defined(__cpp_impl_coroutine)
+    if(coro){ std::cerr<<"Error: -coro requires a C++20 build (g++ -std=c++20)\n"; return 1; }
+#endif
 
     // Phase A: load prefixes
     if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
@@ -237,6 +419,8 @@ int main(int argc, char* argv[]){
     auto tB0 = now(); size_t rssB0 = current_rss_bytes();
     PatriciaTrie trie;
     for(auto& r: recs) trie.insert(r.net, r.len, std::move(r.key));
+    std::vector<FlatNode> flat_nodes; std::vector<const std::vector<uint8_t>*> flat_keys;
+    uint32_t flat_root = simd ? trie.export_flat(flat_nodes, flat_keys) : 0;   // counted as build
     double build_ds_s = secs_since(tB0);
     size_t rssB1 = current_rss_bytes();
     size_t mem_ds_bytes = (rssB1>rssB0? rssB1-rssB0:0);
@@ -264,8 +448,23 @@ int main(int argc, char* argv[]){
     // Phase D: lookup
     auto tD0 = now();
     std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    std::vector<const std::vector<uint8_t>*> keys;
+    bool simd_avx2 = false;
+    if(simd){
+        std::vector<uint32_t> ids(ips.size());
+        auto walk = lpm_flat_batch;
+#ifdef HAVE_X86_KERNELS
+        if(__builtin_cpu_supports("avx2")){ walk = lpm_lockstep_avx2; simd_avx2 = true; }
+#endif
+        walk(flat_nodes.data(), flat_root, ips.data(), ips.size(), ids.data());
+        keys.resize(ips.size());
+        for(size_t i=0;i<ips.size();++i) keys[i] = flat_keys[ids[i]];
+    }
+#if defined(__cpp_impl_coroutine)
+    if(coro){ keys.resize(ips.size()); trie.lpm_interleaved(ips.data(), ips.size(), coro_width, keys.data()); }
+#endif
     for(size_t i=0;i<ips.size();++i){
-        auto* k = trie.lpm(ips[i]);
+        auto* k = (coro||simd)? keys[i] : trie.lpm(ips[i]);
         if(write_hex) results.emplace_back(ip_strs[i], k? bytes_to_hex(*k) : std::string("-1"));
         else          results.emplace_back(ip_strs[i], k? std::string("1") : std::string("-1"));
     }
@@ -294,7 +493,10 @@ int main(int argc, char* argv[]){
               "lookups_per_s,ns_per_lookup,"
               "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb\n";
     }
-    res<< "PatriciaTrie" << ','
+    std::string algo_name = "PatriciaTrie";
+    if(coro) algo_name += "-CORO" + std::to_string(coro_width);
+    if(simd) algo_name += simd_avx2 ? "-SIMD8" : "-FLAT";
+    res<< algo_name << ','
        << PREFIX_FILE << ','
        << IP_FILE << ','
        << num_prefixes << ','
@@ -313,5 +515,9 @@ int main(int argc, char* argv[]){
        << mem_ip_array_mb << ','
        << mem_total_mb << '\n';
 
+    // Optional multithreaded scaling run (plain lpm(), whatever the mode)
+    if(threads>0)
+        mt::run_threads_benchmark("PatriciaTrie", ips, threads, [&](uint32_t ip){ return trie.lpm(ip)!=nullptr; });
+
     return 0;
 }
@@ -0,0 +1,391 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <unistd.h>   // sysconf
+#include <cstdint>
+#include <algorithm>
+#include "mt_lookup.h"
+
+// Hardware popcnt even when built with plain -O2 (otherwise libgcc's software fallback is used)
+#pragma GCC target("popcnt")
+
+/// Poptrie (Asai & Ohara, SIGCOMM'15): 6-bit stride multibit trie whose nodes
+/// hold two 64-bit bitmaps and index contiguous child/leaf arrays via popcnt.
+/// The first 16 bits are resolved by a direct-pointing table.
+///
+/// Usage:
+///   Fast mode (default):   ./src/poptrie
+///   Check mode (hex out):  ./src/poptrie -chk
+
+// ------------------------- Paths -------------------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_poptrie.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_poptrie.csv";
+
+// ------------------------- Helpers -----------------------
+static inline uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+static inline uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& hex) {
+    std::vector<uint8_t> out;
+    out.reserve(hex.size() / 2);
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        out.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const std::vector<uint8_t>& bytes) {
+    std::ostringstream oss;
+    for (auto b : bytes)
+        oss << std::hex << std::setw(2) << std::setfill('0') << int(b);
+    return oss.str();
+}
+static inline bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+static inline auto now() { return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+static inline size_t current_rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double bytes_to_mb(size_t b) { return double(b) / (1024.0 * 1024.0); }
+
+// ------------------------- Data --------------------------
+static const int TOP_BITS = 16;          // direct-pointing bits
+static const int STRIDE   = 6;           // 2^6 = 64 slots per node
+static const uint32_t DP_LEAF = 1u << 31; // direct-pointing entry holds a leaf
+
+struct PopNode {
+    uint64_t vector;   // bit i set -> slot i is an internal child
+    uint64_t leafvec;  // bit i set -> slot i starts a new run of leaves
+    uint32_t base0;    // first leaf in `leaves`
+    uint32_t base1;    // first child in `nodes`
+};
+
+class Poptrie {
+public:
+    // Prefixes go into a scratch binary trie first; build() compiles it.
+    void insert(uint32_t net, uint8_t len, std::vector<uint8_t>&& key) {
+        if (scratch_.empty()) scratch_.push_back(Scratch{});
+        net &= mask_from_len(len);
+        uint32_t n = 0;
+        for (int i = 0; i < len; ++i) {
+            int bit = (net >> (31 - i)) & 1;
+            if (!scratch_[n].child[bit]) {
+                scratch_[n].child[bit] = uint32_t(scratch_.size());
+                scratch_.push_back(Scratch{});
+            }
+            n = scratch_[n].child[bit];
+        }
+        keys_.push_back(std::move(key));
+        scratch_[n].key_id = uint32_t(keys_.size()); // ids are 1-based, 0 = none
+        ++inserted_;
+    }
+
+    void build() {
+        if (scratch_.empty()) scratch_.push_back(Scratch{});
+        direct_.assign(size_t(1) << TOP_BITS, DP_LEAF);
+        for (uint32_t i = 0; i < (1u << TOP_BITS); ++i) {
+            uint32_t best = 0;
+            uint32_t n = descend(0, 0, i, TOP_BITS, best);
+            if (n && has_children(n)) {
+                uint32_t idx = uint32_t(nodes_.size());
+                nodes_.push_back(PopNode{});
+                build_node(idx, n, TOP_BITS, best);
+                direct_[i] = idx;
+            } else {
+                direct_[i] = DP_LEAF | best;
+            }
+        }
+        scratch_.clear();
+        scratch_.shrink_to_fit();
+    }
+
+    const std::vector<uint8_t>* lpm(uint32_t ip) const {
+        uint32_t e = direct_[ip >> (32 - TOP_BITS)];
+        uint64_t key = uint64_t(ip) << 32;   // zero-pad past bit 31
+        int depth = TOP_BITS;
+        while (!(e & DP_LEAF)) {
+            const PopNode& n = nodes_[e];
+            uint32_t v = uint32_t((key << depth) >> (64 - STRIDE));
+            uint64_t upto = (2ULL << v) - 1;   // bits [0..v]
+            if (n.vector & (1ULL << v)) {
+                e = n.base1 + uint32_t(__builtin_popcountll(n.vector & upto)) - 1;
+                depth += STRIDE;
+            } else {
+                uint32_t id = leaves_[n.base0 + uint32_t(__builtin_popcountll(n.leafvec & upto)) - 1];
+                return id ? &keys_[id - 1] : nullptr;
+            }
+        }
+        uint32_t id = e & ~DP_LEAF;
+        return id ? &keys_[id - 1] : nullptr;
+    }
+
+    size_t inserted() const { return inserted_; }
+    size_t node_count() const { return nodes_.size(); }
+    size_t leaf_count() const { return leaves_.size(); }
+
+private:
+    struct Scratch {
+        uint32_t child[2]{0, 0};   // 0 = none (root is never a child)
+        uint32_t key_id = 0;
+    };
+    std::vector<Scratch> scratch_;
+    std::vector<std::vector<uint8_t>> keys_;
+    std::vector<uint32_t> direct_;
+    std::vector<PopNode> nodes_;
+    std::vector<uint32_t> leaves_;
+    size_t inserted_ = 0;
+
+    bool has_children(uint32_t n) const {
+        return scratch_[n].child[0] || scratch_[n].child[1];
+    }
+
+    // Walk `bits` bits of `path` from scratch node n at `depth`, updating the
+    // best key id seen. Returns the node reached, or 0 if the path falls off.
+    uint32_t descend(uint32_t n, int depth, uint32_t path, int bits, uint32_t& best) const {
+        if (scratch_[n].key_id) best = scratch_[n].key_id;
+        for (int i = bits - 1; i >= 0 && depth < 32; --i, ++depth) {
+            n = scratch_[n].child[(path >> i) & 1];
+            if (!n) return 0;
+            if (scratch_[n].key_id) best = scratch_[n].key_id;
+        }
+        return n;
+    }
+
+    // Fill nodes_[idx] for the subtree at scratch node n (at `depth`), where
+    // `inherited` is the best key id on the path above it.
+    void build_node(uint32_t idx, uint32_t n, int depth, uint32_t inherited) {
+        uint32_t child_at[64], best_at[64];
+        uint64_t vector = 0, leafvec = 0;
+        std::vector<uint32_t> leaf_ids;
+        bool have_prev = false;
+        uint32_t prev = 0;
+
+        for (uint32_t v = 0; v < 64; ++v) {
+            uint32_t best = inherited;
+            uint32_t c = (depth + STRIDE <= 32)
+                ? descend(n, depth, v, STRIDE, best)
+                : descend(n, depth, v >> (depth + STRIDE - 32), 32 - depth, best);
+            child_at[v] = c; best_at[v] = best;
+            if (c && has_children(c)) {
+                vector |= 1ULL << v;
+            } else if (!have_prev || best != prev) {
+                leafvec |= 1ULL << v;
+                leaf_ids.push_back(best);
+                prev = best; have_prev = true;
+            }
+        }
+
+        PopNode node{vector, leafvec, uint32_t(leaves_.size()), uint32_t(nodes_.size())};
+        leaves_.insert(leaves_.end(), leaf_ids.begin(), leaf_ids.end());
+        nodes_.resize(nodes_.size() + size_t(__builtin_popcountll(vector)));
+        nodes_[idx] = node;
+
+        uint32_t next = node.base1;
+        for (uint32_t v = 0; v < 64; ++v) {
+            if (vector & (1ULL << v)) build_node(next++, child_at[v], depth + STRIDE, best_at[v]);
+        }
+    }
+};
+
+struct PrefixRec {
+    uint32_t net;
+    uint8_t len;
+    std::vector<uint8_t> key; // will be moved into trie
+};
+
+// ------------------------- Main --------------------------
+int main(int argc, char* argv[]) {
+    bool write_hex = false;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-chk" || a == "--chk") write_hex = true;
+        else if ((a == "-threads" || a == "--threads") && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if (a == "-h" || a == "--help") {
+            std::cout <<
+                "Usage: " << argv[0] << " [-chk] [--threads N]\n"
+                "  -chk          Write hex keys to benchmarks/match_poptrie.csv (slower)\n"
+                "  --threads N   Also measure lookup scaling on N pinned threads\n"
+                "                (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line;
+    std::getline(pf, line); // header: prefix,key
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000);
+
+    size_t num_prefixes = 0;
+    while (std::getline(pf, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',') || !std::getline(ss, key_hex)) continue;
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        if (len > 32) continue;  // Skip invalid prefix lengths
+        uint32_t net = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        prefixes.push_back({net, len, hex_to_bytes(key_hex)});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // -------- Phase B: Build poptrie --------
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+
+    Poptrie trie;
+    for (auto& rec : prefixes) {
+        trie.insert(rec.net, rec.len, std::move(rec.key));
+    }
+    trie.build();
+
+    double build_ds_s = secs_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header: ip,used_prefix
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1<<20);
+    ip_strs.reserve(1<<20);
+
+    while (std::getline(ipf, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, dummy;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, dummy);
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // -------- Phase D: Lookup timing --------
+    auto tD0 = now();
+    std::vector<std::pair<std::string,std::string>> results;
+    results.reserve(ips.size());
+
+    for (size_t i = 0; i < ips.size(); ++i) {
+        const auto* key = trie.lpm(ips[i]);
+        if (write_hex) {
+            results.emplace_back(ip_strs[i], key ? bytes_to_hex(*key) : std::string("-1"));
+        } else {
+            results.emplace_back(ip_strs[i], key ? std::string("1") : std::string("-1"));
+        }
+    }
+    double lookup_s = secs_since(tD0);
+
+    double ns_per_lookup = ips.empty() ? 0.0 : (lookup_s * 1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write matches --------
+    {
+        std::ofstream out(MATCH_FILE, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (auto& r : results) out << r.first << "," << r.second << "\n";
+        }
+    }
+
+    // -------- Final mem & write results CSV --------
+    size_t rss_total_bytes = current_rss_bytes();
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(rss_total_bytes);
+
+    const char* algo_name = "Poptrie";
+    bool need_header = !file_exists(RESULTS_FILE);
+
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if (!res) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        res.setf(std::ios::fixed);
+        if (need_header) {
+            res << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                   "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                   "lookups_per_s,ns_per_lookup,"
+                   "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb\n";
+        }
+        res << algo_name << ","
+            << PREFIX_FILE << ","
+            << IP_FILE << ","
+            << num_prefixes << ","
+            << ips.size() << ","
+            << std::setprecision(6)
+            << prefix_load_s << ","
+            << build_ds_s << ","
+            << ip_load_s << ","
+            << lookup_s << ","
+            << std::setprecision(2)
+            << lookups_per_s << ","
+            << ns_per_lookup << ","
+            << std::setprecision(2)
+            << mem_prefix_array_mb << ","
+            << mem_ds_mb << ","
+            << mem_ip_array_mb << ","
+            << mem_total_mb
+            << "\n";
+    }
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if (threads > 0)
+        mt::run_threads_benchmark(algo_name, ips, threads,
+                                  [&](uint32_t ip) { return trie.lpm(ip) != nullptr; });
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <unordered_set>
+#include <random>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cstdint>
+
+// IPv6 counterpart of prefix_gen.cpp: writes data/prefix_table_v6.csv.
+// Lengths follow the shape of real IPv6 tables: mostly /16-/64 with peaks at
+// /32, /48 and /64, plus a few longer routes (/65-/128).
+
+typedef unsigned __int128 u128;
+
+std::string ip6_prefix_to_string(u128 network_prefix, uint8_t prefix_len) {
+    in6_addr addr;
+    for (int i = 0; i < 16; ++i)
+        addr.s6_addr[i] = static_cast<uint8_t>(network_prefix >> (120 - 8 * i));
+    char ip_str[INET6_ADDRSTRLEN];
+    inet_ntop(AF_INET6, &addr, ip_str, INET6_ADDRSTRLEN);
+    return std::string(ip_str) + "/" + std::to_string(prefix_len);
+}
+
+std::string bytes_to_hex(const std::vector<uint8_t>& bytes) {
+    std::ostringstream oss;
+    for (auto b : bytes)
+        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(b);
+    return oss.str();
+}
+
+int main(int argc, char* argv[]) {
+    // Default: 10000 prefixes if no argument provided
+    int N = 10000;
+    if (argc >= 2) {
+        try {
+            N = std::stoi(argv[1]);
+            if (N <= 0) {
+                std::cerr << "Number of prefixes must be > 0.\n";
+                return 1;
+            }
+        } catch (...) {
+            std::cerr << "Invalid number format for prefixes.\n";
+            return 1;
+        }
+    }
+
+    std::random_device rd;
+    std::mt19937_64 rng(rd());
+    std::uniform_int_distribution<uint8_t> byte_dist(0, 255);
+
+    // Length weights (per mille): /16-/64 heavy
+    const std::vector<std::pair<int, int>> len_weights = {
+        {16, 5}, {19, 5}, {20, 10}, {24, 15}, {28, 30}, {29, 60}, {30, 10},
+        {32, 150}, {33, 10}, {34, 10}, {35, 10}, {36, 40}, {40, 70}, {42, 10},
+        {44, 60}, {45, 10}, {46, 20}, {47, 20}, {48, 300}, {52, 10}, {56, 40},
+        {60, 10}, {64, 50}, {96, 5}, {112, 5}, {127, 5}, {128, 25}
+    };
+    std::vector<int> weights;
+    for (const auto& lw : len_weights) weights.push_back(lw.second);
+    std::discrete_distribution<size_t> len_pick(weights.begin(), weights.end());
+
+    std::unordered_set<std::string> prefix_set;
+
+    struct FibEntry {
+        std::string prefix_str;
+        std::string key_hex;
+        uint8_t prefix_len;
+    };
+
+    std::vector<FibEntry> entries;
+
+    int count = 0;
+    while (count < N) {
+        uint8_t prefix_len = static_cast<uint8_t>(len_weights[len_pick(rng)].first);
+        // global unicast space (2000::/3)
+        u128 ip = (u128(rng()) << 64) | rng();
+        ip = (ip & (~u128(0) >> 3)) | (u128(1) << 125);
+        u128 mask = prefix_len == 0 ? 0 : (~u128(0) << (128 - prefix_len));
+        u128 network_prefix = ip & mask;
+
+        std::string prefix_str = ip6_prefix_to_string(network_prefix, prefix_len);
+        if (prefix_set.find(prefix_str) != prefix_set.end())
+            continue;
+
+        prefix_set.insert(prefix_str);
+
+        std::vector<uint8_t> key(64);
+        for (auto& b : key)
+            b = byte_dist(rng);
+
+        entries.push_back({prefix_str, bytes_to_hex(key), prefix_len});
+        count++;
+    }
+
+    // Sort by prefix_len descending
+    std::sort(entries.begin(), entries.end(),
+              [](const FibEntry& a, const FibEntry& b) {
+                  return a.prefix_len > b.prefix_len;
+              });
+
+    std::ofstream fout("data/prefix_table_v6.csv");
+    fout << "prefix,key\n";
+    for (const auto& entry : entries)
+        fout << entry.prefix_str << "," << entry.key_hex << "\n";
+
+    std::cout << "Generated sorted prefix_table_v6.csv with " << N << " unique, aligned prefixes.\n";
+    return 0;
+}
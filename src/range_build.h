@@ -0,0 +1,59 @@
+// range_build.h -- prefix-to-range decomposition shared by the range engines.
+//
+// dxr_range, eytzinger, stree and learned all search the same thing: the
+// sorted, disjoint address ranges that a prefix table cuts IPv4 space into.
+// build_ranges() produces them once with a single sweep over the prefixes
+// sorted by (base, len), keeping the currently open (enclosing) prefixes on a
+// stack. Each engine then lays the range starts out in its own search
+// structure.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct PRec{ uint32_t base; uint8_t len; uint32_t key_id; };
+struct Range{ uint32_t start; uint32_t key_id; };
+
+// Turn (possibly nested) prefixes into sorted, disjoint ranges covering the
+// whole address space. Each range holds the key id of the longest covering
+// prefix (0 where nothing matches); neighbours with equal ids are merged.
+inline std::vector<Range> build_ranges(std::vector<PRec> pfx){
+    std::stable_sort(pfx.begin(), pfx.end(), [](const PRec& a, const PRec& b){
+        return a.base != b.base ? a.base < b.base : a.len < b.len;
+    });
+
+    std::vector<Range> out;
+    auto emit = [&](uint64_t start, uint32_t id){
+        if(start > 0xFFFFFFFFull) return;
+        if(!out.empty() && out.back().start == uint32_t(start)) out.back().key_id = id;
+        else out.push_back({uint32_t(start), id});
+    };
+
+    struct Open{ uint64_t end; uint32_t key_id; };   // end is inclusive
+    std::vector<Open> stack;
+    emit(0, 0);
+    for(const auto& p : pfx){
+        uint64_t end = uint64_t(p.base) + (uint64_t(1) << (32 - p.len)) - 1;
+        while(!stack.empty() && stack.back().end < p.base){
+            uint64_t closed = stack.back().end;
+            stack.pop_back();
+            emit(closed + 1, stack.empty() ? 0 : stack.back().key_id);
+        }
+        emit(p.base, p.key_id);
+        stack.push_back({end, p.key_id});
+    }
+    while(!stack.empty()){
+        uint64_t closed = stack.back().end;
+        stack.pop_back();
+        emit(closed + 1, stack.empty() ? 0 : stack.back().key_id);
+    }
+
+    // merge neighbours with the same key id
+    std::vector<Range> merged; merged.reserve(out.size());
+    for(const auto& r : out){
+        if(!merged.empty() && merged.back().key_id == r.key_id) continue;
+        merged.push_back(r);
+    }
+    return merged;
+}
@@ -0,0 +1,376 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <unistd.h>   // sysconf
+#include "mt_lookup.h"
+
+// SAIL (Yang et al., "Guarantee IP Lookup Performance with FIB Explosion").
+// Prefixes are split into three levels with pivot pushing: /0../16 are pushed
+// to /16, /17../24 to /24 and /25../32 to /32. Bitmaps B16 and B24 mark pivot
+// slots, i.e. /16 and /24 blocks that contain longer prefixes. A lookup checks
+// B16 then B24 to pick the level; a pivot's N16/N24 entry holds the chunk id of
+// its 256-entry block in the next level instead of a key id. After pushing,
+// every N32 entry is final, so B32 is implicit.
+
+// ------------------------- Config / constants -------------------------
+static const int N16_SIZE   = 1 << 16;
+static const int B24_BITS   = 1 << 24;
+static const int CHUNK_SIZE = 256;
+
+// File paths (relative to repo root)
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_sail.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_sail.csv";
+
+// ------------------------- Memory / timing helpers --------------------
+size_t current_rss_bytes() {
+    // Linux: /proc/self/statm (resident pages * page size)
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+inline auto now() {
+    return std::chrono::high_resolution_clock::now();
+}
+inline double seconds_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+inline double bytes_to_mb(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// ------------------------- Utilities ---------------------------------
+uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+std::string bytes_to_hex(const uint8_t* key, int len = 64) {
+    std::ostringstream oss;
+    for (int i = 0; i < len; ++i) {
+        oss << std::hex << std::setw(2) << std::setfill('0')
+            << static_cast<int>(key[i]);
+    }
+    return oss.str();
+}
+bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+
+// ------------------------- Data structures ---------------------------
+struct PrefixRec {
+    uint32_t base_ip;  // aligned network address
+    uint8_t  len;      // prefix length
+    uint32_t key_id;   // index into g_keys (0 = no key)
+};
+std::unordered_map<std::string, uint32_t> g_key_ids;
+std::vector<uint8_t*> g_keys(1, nullptr);
+
+// SAIL tables
+std::vector<uint64_t> B16;   // [2^16 bits] pivot at /16
+std::vector<uint64_t> B24;   // [2^24 bits] pivot at /24
+std::vector<uint32_t> N16;   // [2^16] key id, or N24 chunk id when B16 is set
+std::vector<uint32_t> N24;   // [chunks*256] key id, or N32 chunk id when B24 is set
+std::vector<uint32_t> N32;   // [chunks*256] key id
+
+inline bool test_bit(const std::vector<uint64_t>& bm, uint32_t i) {
+    return (bm[i >> 6] >> (i & 63)) & 1ULL;
+}
+inline void set_bit(std::vector<uint64_t>& bm, uint32_t i) {
+    bm[i >> 6] |= 1ULL << (i & 63);
+}
+
+// ------------------------- Key handling -------------------------------
+uint32_t get_or_create_key_id(const std::string& hex) {
+    if (hex.size() != 128) return 0;
+    auto it = g_key_ids.find(hex);
+    if (it != g_key_ids.end()) return it->second;
+
+    uint8_t* bytes = new uint8_t[64];
+    for (size_t i = 0; i < 128; i += 2) {
+        bytes[i/2] = static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16));
+    }
+    uint32_t id = static_cast<uint32_t>(g_keys.size());
+    g_keys.push_back(bytes);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ------------------------- Build --------------------------------------
+// Turn /16 slot `top` into a pivot, pushing its current key id into a new N24 chunk.
+uint32_t ensure_chunk24(uint32_t top) {
+    if (test_bit(B16, top)) return N16[top];
+    uint32_t chunk = static_cast<uint32_t>(N24.size() / CHUNK_SIZE);
+    N24.resize(N24.size() + CHUNK_SIZE, N16[top]);
+    N16[top] = chunk;
+    set_bit(B16, top);
+    return chunk;
+}
+// Turn /24 slot `ip24` into a pivot, pushing its current key id into a new N32 chunk.
+uint32_t ensure_chunk32(uint32_t ip24) {
+    uint32_t slot = ensure_chunk24(ip24 >> 8) * CHUNK_SIZE + (ip24 & 0xFF);
+    if (test_bit(B24, ip24)) return N24[slot];
+    uint32_t chunk = static_cast<uint32_t>(N32.size() / CHUNK_SIZE);
+    N32.resize(N32.size() + CHUNK_SIZE, N24[slot]);
+    N24[slot] = chunk;
+    set_bit(B24, ip24);
+    return chunk;
+}
+
+// Prefixes must be sorted by ascending length so that pivot pushing copies the
+// final shorter-prefix value into each new chunk and longer prefixes overwrite.
+void build_sail(const std::vector<PrefixRec>& prefixes) {
+    B16.assign(N16_SIZE / 64, 0);
+    B24.assign(B24_BITS / 64, 0);
+    N16.assign(N16_SIZE, 0);
+    N24.clear();
+    N32.clear();
+
+    for (const auto& rec : prefixes) {
+        const uint32_t ip = rec.base_ip;
+        const uint8_t len = rec.len;
+        const uint32_t id = rec.key_id;
+
+        if (len <= 16) {
+            const uint32_t start = ip >> 16;
+            const uint32_t fill  = 1u << (16 - len);
+            for (uint32_t i = 0; i < fill; ++i) N16[start + i] = id;
+        } else if (len <= 24) {
+            const uint32_t chunk = ensure_chunk24(ip >> 16);
+            const uint32_t start = chunk * CHUNK_SIZE + ((ip >> 8) & 0xFF);
+            const uint32_t fill  = 1u << (24 - len);
+            for (uint32_t i = 0; i < fill; ++i) N24[start + i] = id;
+        } else {
+            const uint32_t chunk = ensure_chunk32(ip >> 8);
+            const uint32_t start = chunk * CHUNK_SIZE + (ip & 0xFF);
+            const uint32_t fill  = 1u << (32 - len);
+            for (uint32_t i = 0; i < fill; ++i) N32[start + i] = id;
+        }
+    }
+}
+
+inline uint32_t sail_lookup(uint32_t ip) {
+    const uint32_t i16 = ip >> 16;
+    const uint32_t v16 = N16[i16];
+    if (!test_bit(B16, i16)) return v16;
+
+    const uint32_t i24 = ip >> 8;
+    const uint32_t v24 = N24[v16 * CHUNK_SIZE + (i24 & 0xFF)];
+    if (!test_bit(B24, i24)) return v24;
+
+    return N32[v24 * CHUNK_SIZE + (ip & 0xFF)];
+}
+
+// ------------------------- Main --------------------------------------
+int main(int argc, char* argv[]) {
+    // Check for -chk flag to output hex keys
+    bool write_hex = false;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-chk" || arg == "--chk") {
+            write_hex = true;
+        } else if ((arg == "-threads" || arg == "--threads") && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [-chk] [--threads N]\n"
+                      << "  -chk          Write hex keys to match file (slower)\n"
+                      << "  --threads N   Also measure lookup scaling on N pinned threads\n"
+                      << "                (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // ----------------- Phase A: Load Prefixes (batch) -----------------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream fib(PREFIX_FILE);
+    std::string line;
+    std::getline(fib, line); // skip header "prefix,key"
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000); // guess; adjust as needed
+
+    size_t num_prefixes = 0;
+    while (std::getline(fib, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',')) continue;
+        if (!std::getline(ss, key_hex)) continue;
+
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        if (len > 32) continue;  // Skip invalid prefix lengths
+        uint32_t base_ip = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(key_hex);
+        if (!key_id) continue;
+        prefixes.push_back({base_ip, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = seconds_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // ----------------- Phase B: Build DS (SAIL) -----------------------
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const PrefixRec& a, const PrefixRec& b) { return a.len < b.len; });
+    build_sail(prefixes);
+
+    double build_ds_s = seconds_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+
+    // Optional: free prefix array to observe DS-only memory
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    // ----------------- Phase C: Load IPs (batch) ----------------------
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipfile(IP_FILE);
+    std::getline(ipfile, line); // skip header "ip,used_prefix"
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1000000); ip_strs.reserve(1000000); // guess; adjust as needed
+
+    while (std::getline(ipfile, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, discard;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, discard); // used_prefix (ignored for speed)
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = seconds_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // ----------------- Phase D: Lookup -------------------------------
+    auto tD0 = now();
+
+    std::vector<std::string> results;
+    results.reserve(ips.size());
+
+    for (uint32_t ip : ips) {
+        uint8_t* key = g_keys[sail_lookup(ip)];
+        if (write_hex) {
+            results.emplace_back(key ? bytes_to_hex(key) : "-1");
+        } else {
+            results.emplace_back(key ? "1" : "-1");
+        }
+    }
+
+    double lookup_time_s = seconds_since(tD0);
+    double ns_per_lookup = (ips.empty() ? 0.0 : (lookup_time_s * 1e9 / static_cast<double>(ips.size())));
+    double lookups_per_s = (lookup_time_s > 0.0 ? (static_cast<double>(ips.size()) / lookup_time_s) : 0.0);
+
+    // ----------------- Output matches -------------------------------
+    {
+        std::ofstream out(MATCH_FILE);
+        if (!out.is_open()) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (size_t i = 0; i < ips.size(); ++i) {
+                out << ip_strs[i] << "," << results[i] << "\n";
+            }
+        }
+    }
+
+    // ----------------- Final memory totals --------------------------
+    size_t rss_total_bytes = current_rss_bytes();
+
+    // Convert memory to MB for output
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(rss_total_bytes);
+
+    // ----------------- Append metrics CSV ---------------------------
+    // Columns:
+    // algorithm,prefix_file,ip_file,num_prefixes,num_ips,
+    // prefix_load_s,build_ds_s,ip_load_s,lookup_s,lookups_per_s,ns_per_lookup,
+    // mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb
+    const char* algo_name = "SAIL";
+
+    bool write_header = !file_exists(RESULTS_FILE);
+    std::ofstream r(RESULTS_FILE, std::ios::app);
+    if (!r.is_open()) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        r.setf(std::ios::fixed);
+        if (write_header) {
+            r << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                 "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                 "lookups_per_s,ns_per_lookup,"
+                 "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb\n";
+        }
+        r << algo_name << ","
+          << PREFIX_FILE << ","
+          << IP_FILE << ","
+          << num_prefixes << ","
+          << ips.size() << ","
+          << std::setprecision(6)
+          << prefix_load_s << ","
+          << build_ds_s << ","
+          << ip_load_s << ","
+          << lookup_time_s << ","
+          << std::setprecision(2) << lookups_per_s << ","
+          << std::setprecision(2) << ns_per_lookup << ","
+          << std::setprecision(2)
+          << mem_prefix_array_mb << ","
+          << mem_ds_mb << ","
+          << mem_ip_array_mb << ","
+          << mem_total_mb
+          << "\n";
+    }
+
+    // ----------------- Optional: multithreaded scaling run ---------
+    if (threads > 0)
+        mt::run_threads_benchmark(algo_name, ips, threads,
+                                  [](uint32_t ip) { return sail_lookup(ip) != 0; });
+
+    // ----------------- Cleanup -------------------------------------
+    for (auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
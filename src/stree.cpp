@@ -0,0 +1,299 @@
+// src/stree.cpp
+// Static 16-way B+-tree (S-tree) over prefix interval starts.
+//
+// The prefix table is flattened into disjoint address ranges, each carrying the
+// key id of its longest matching prefix. The sorted range starts form the leaf
+// level, 16 per 64-byte node; each internal node holds the first start of 16 of
+// its 17 children. A node is searched with two AVX2 compares and a movemask,
+// so every level costs one cache line (about 5 levels for 1M prefixes).
+//
+// Build with -mavx2 (or -march=native) for the vector node search; otherwise a
+// scalar loop counts the keys.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <algorithm>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdlib>   // aligned_alloc
+#include "mt_lookup.h"
+#include "range_build.h"
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// ---------------- Paths ----------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_stree.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_stree.csv";
+
+// ---------------- Utils ----------------
+static inline uint32_t mask_from_len(uint8_t len){ return (len==0)?0U:(~0U << (32-len)); }
+static inline uint32_t ip_str_to_uint(const std::string& s){ in_addr a{}; inet_pton(AF_INET,s.c_str(),&a); return ntohl(a.s_addr); }
+static inline bool file_exists(const char* p){ std::ifstream f(p); return f.good(); }
+
+static inline auto now(){ return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t){ return std::chrono::duration<double>(now()-t).count(); }
+
+static inline size_t rss_bytes(){
+    std::ifstream statm("/proc/self/statm"); size_t sz=0,res=0; if(statm) statm>>sz>>res;
+    return res * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double to_mb(size_t b){ return double(b)/(1024.0*1024.0); }
+
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& h){
+    std::vector<uint8_t> out; out.reserve(h.size()/2);
+    for(size_t i=0;i+1<h.size(); i+=2) out.push_back(uint8_t(std::stoi(h.substr(i,2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const uint8_t* key, int len=64){
+    std::ostringstream oss;
+    for(int i=0;i<len;++i) oss<<std::hex<<std::setw(2)<<std::setfill('0')<<int(key[i]);
+    return oss.str();
+}
+
+// ---------------- Key pool (dedup, id-indexed) ----------------
+// key id 0 is reserved for "no match"
+static std::unordered_map<std::string, uint32_t> g_key_ids;
+static std::vector<uint8_t*> g_keys(1, nullptr);
+
+static inline uint32_t get_or_create_key_id(const std::string& hex){
+    auto it = g_key_ids.find(hex);
+    if(it != g_key_ids.end()) return it->second;
+    std::vector<uint8_t> tmp = hex_to_bytes(hex);
+    if(tmp.size() != 64) return 0;
+    uint8_t* p = new uint8_t[64];
+    std::memcpy(p, tmp.data(), 64);
+    uint32_t id = uint32_t(g_keys.size());
+    g_keys.push_back(p);
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+// ---------------- S-tree ----------------
+// Keys are stored biased (x ^ 0x80000000) so AVX2's signed compare orders
+// them as unsigned. Padding keys are all-ones; they only appear in the last
+// node of a level, and the child/leaf index is clamped to the real range.
+static const int      B    = 16;       // keys per node (one cache line)
+static const uint32_t BIAS = 0x80000000u;
+
+struct STree {
+    uint32_t* keys = nullptr;              // all levels, node-aligned
+    std::vector<size_t>   level_off;       // first node of level l (0 = leaves)
+    std::vector<uint32_t> level_nodes;     // nodes in level l
+    std::vector<uint32_t> key_ids;         // key id of sorted range i
+    uint32_t n = 0;
+
+    void build(const std::vector<Range>& ranges){
+        n = uint32_t(ranges.size());
+        key_ids.resize(n);
+        for(uint32_t i=0;i<n;++i) key_ids[i] = ranges[i].key_id;
+
+        // node counts: leaves hold B keys, internal nodes have B+1 children
+        level_nodes.push_back((n + B - 1) / B);
+        while(level_nodes.back() > 1) level_nodes.push_back((level_nodes.back() + B) / (B + 1));
+        size_t total = 0;
+        for(uint32_t m : level_nodes){ level_off.push_back(total); total += m; }
+
+        keys = static_cast<uint32_t*>(std::aligned_alloc(64, total * B * sizeof(uint32_t)));
+        std::fill(keys, keys + total * B, ~0u);
+
+        // first start of every node of the level below, per level
+        std::vector<uint32_t> firsts(level_nodes[0]);
+        uint32_t* leaf = keys + level_off[0] * B;
+        for(uint32_t i=0;i<n;++i) leaf[i] = ranges[i].start ^ BIAS;
+        for(uint32_t j=0;j<level_nodes[0];++j) firsts[j] = ranges[size_t(j) * B].start;
+
+        for(size_t l=1;l<level_nodes.size();++l){
+            uint32_t* lv = keys + level_off[l] * B;
+            std::vector<uint32_t> next(level_nodes[l]);
+            for(uint32_t j=0;j<level_nodes[l];++j){
+                size_t c0 = size_t(j) * (B + 1);
+                next[j] = firsts[c0];
+                for(int c=1;c<=B && c0 + c < firsts.size();++c) lv[size_t(j) * B + c - 1] = firsts[c0 + c] ^ BIAS;
+            }
+            firsts.swap(next);
+        }
+    }
+
+    // number of keys in the node that are <= x (x already biased)
+    static inline uint32_t rank(const uint32_t* node, uint32_t x){
+#ifdef __AVX2__
+        __m256i vx = _mm256_set1_epi32(int(x));
+        __m256i a  = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i*)node),     vx);
+        __m256i b  = _mm256_cmpgt_epi32(_mm256_load_si256((const __m256i*)(node+8)), vx);
+        uint32_t gt = uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(a)))
+                    | uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(b))) << 8;
+        return uint32_t(__builtin_ctz(gt | (1u << B)));   // keys are sorted: gt is a suffix
+#else
+        uint32_t c = 0;
+        while(c < uint32_t(B) && int32_t(node[c]) <= int32_t(x)) ++c;
+        return c;
+#endif
+    }
+
+    inline uint32_t lookup(uint32_t ip) const {
+        uint32_t x = ip ^ BIAS;
+        uint32_t j = 0;
+        for(size_t l = level_nodes.size() - 1; l > 0; --l){
+            uint32_t c = rank(keys + (level_off[l] + j) * B, x);
+            j = std::min(j * (B + 1) + c, level_nodes[l-1] - 1);
+        }
+        uint32_t idx = std::min(j * B + rank(keys + (level_off[0] + j) * B, x), n);
+        return key_ids[idx - 1];     // range 0 starts at 0, so idx >= 1
+    }
+
+    size_t bytes() const {
+        size_t total = 0; for(uint32_t m : level_nodes) total += m;
+        return total * B * sizeof(uint32_t) + key_ids.size() * sizeof(uint32_t);
+    }
+
+    ~STree(){ std::free(keys); }
+};
+
+int main(int argc, char* argv[]){
+    bool write_hex = false;
+    int threads = 0;
+    for(int i=1;i<argc;++i){
+        std::string a = argv[i];
+        if(a=="-chk"||a=="--chk") write_hex = true;
+        else if((a=="-threads"||a=="--threads") && i+1<argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if(a=="-h"||a=="--help"){
+            std::cout<<"Usage: "<<argv[0]<<" [-chk] [--threads N]\n"
+                       "  -chk   Write hex keys to match file (slower)\n"
+                       "  --threads N  Also measure lookup scaling on N pinned threads (results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // -------- Phase A: Load prefixes (batch) --------
+    if(!file_exists(PREFIX_FILE)){ std::cerr<<"Error: cannot open "<<PREFIX_FILE<<"\n"; return 1; }
+    auto tA0=now(); size_t rA0=rss_bytes();
+
+    std::vector<PRec> prefixes; prefixes.reserve(200000);
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line; std::getline(pf, line); // header "prefix,key"
+
+    size_t num_prefixes=0;
+    while(std::getline(pf, line)){
+        std::istringstream ss(line);
+        std::string pfx, khex;
+        if(!std::getline(ss, pfx, ',')) continue;
+        if(!std::getline(ss, khex)) continue;
+
+        auto slash = pfx.find('/');
+        if(slash == std::string::npos) continue;
+        uint32_t net = ip_str_to_uint(pfx.substr(0, slash));
+        uint8_t  len = (uint8_t)std::stoi(pfx.substr(slash+1));
+        if(len > 32) continue;  // Skip invalid prefix lengths
+        net &= mask_from_len(len);
+
+        uint32_t key_id = get_or_create_key_id(khex);
+        if(!key_id) continue;
+
+        prefixes.push_back({net, len, key_id});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    double mem_prefix_mb = to_mb(rss_bytes() - rA0);
+
+    // -------- Phase B: Build S-tree --------
+    auto tB0=now(); size_t rB0=rss_bytes();
+
+    STree st;
+    st.build(build_ranges(prefixes));
+
+    double build_ds_s = secs_since(tB0);
+    double mem_ds_mb  = to_mb(rss_bytes() - rB0);
+
+    prefixes.clear(); prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if(!file_exists(IP_FILE)){ std::cerr<<"Error: cannot open "<<IP_FILE<<"\n"; return 1; }
+    auto tC0=now(); size_t rC0=rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header "ip,used_prefix"
+
+    std::vector<std::string> ip_strs; ip_strs.reserve(1<<20);
+    std::vector<uint32_t>    ips;     ips.reserve(1<<20);
+
+    while(std::getline(ipf, line)){
+        std::istringstream ss(line);
+        std::string ip_s, dump;
+        if(!std::getline(ss, ip_s, ',')) continue;
+        std::getline(ss, dump);
+        ip_strs.push_back(ip_s);
+        ips.push_back(ip_str_to_uint(ip_s));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    double mem_ip_mb = to_mb(rss_bytes() - rC0);
+
+    // -------- Phase D: Lookup --------
+    auto tD0=now();
+
+    std::vector<std::pair<std::string,std::string>> results; results.reserve(ips.size());
+    for(size_t i=0;i<ips.size();++i){
+        uint8_t* key = g_keys[st.lookup(ips[i])];
+        if(write_hex) results.emplace_back(ip_strs[i], key ? bytes_to_hex(key) : std::string("-1"));
+        else          results.emplace_back(ip_strs[i], key ? std::string("1")   : std::string("-1"));
+    }
+
+    double lookup_s = secs_since(tD0);
+    double ns_per_lookup = ips.empty()? 0.0 : (lookup_s*1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write match file --------
+    {
+        std::ofstream out(MATCH_FILE);
+        out<<"ip,key\n";
+        for(auto& r : results) out<<r.first<<','<<r.second<<'\n';
+    }
+
+    // -------- Metrics CSV (MB) --------
+    double mem_total_mb = to_mb(rss_bytes());
+    bool need_header = !file_exists(RESULTS_FILE);
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if(need_header){
+        res<<"algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+              "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+              "lookups_per_s,ns_per_lookup,"
+              "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb\n";
+    }
+#ifdef __AVX2__
+    const char* algo_name = "S-Tree-AVX2";
+#else
+    const char* algo_name = "S-Tree";
+#endif
+    res<<algo_name<<','
+       <<PREFIX_FILE<<','<<IP_FILE<<','
+       <<num_prefixes<<','<<ips.size()<<','
+       <<std::fixed<<std::setprecision(6)
+       <<prefix_load_s<<','<<build_ds_s<<','<<ip_load_s<<','<<lookup_s<<','
+       <<std::setprecision(2)
+       <<lookups_per_s<<','<<ns_per_lookup<<','
+       <<std::setprecision(2)
+       <<mem_prefix_mb<<','<<mem_ds_mb<<','<<mem_ip_mb<<','<<mem_total_mb<<'\n';
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if(threads>0)
+        mt::run_threads_benchmark(algo_name, ips, threads, [&](uint32_t ip){ return st.lookup(ip)!=0; });
+
+    // -------- Cleanup (keys) --------
+    for(auto* k : g_keys) delete[] k;
+    g_keys.clear();
+    g_key_ids.clear();
+
+    return 0;
+}
@@ -0,0 +1,417 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <unistd.h>   // sysconf
+#include <cstdint>
+#include <algorithm>
+#include "mt_lookup.h"
+
+#pragma GCC target("popcnt")
+
+/// Tree Bitmap (Eatherton/Varghese/Dittia) multibit trie with stride 4, 5 or 8.
+/// Each node carries an internal bitmap (prefixes ending inside the node) and
+/// an external bitmap (which children exist); children and results of a node
+/// live in contiguous blocks addressed by popcount rank.
+///
+/// Usage:
+///   Fast mode (default):   ./src/tree_bitmap [-s 4|5|8]
+///   Check mode (hex out):  ./src/tree_bitmap -chk [-s 4|5|8]
+
+// ------------------------- Paths -------------------------
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_tree_bitmap.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_tree_bitmap.csv";
+
+// ------------------------- Helpers -----------------------
+static inline uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+static inline uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+static inline std::vector<uint8_t> hex_to_bytes(const std::string& hex) {
+    std::vector<uint8_t> out;
+    out.reserve(hex.size() / 2);
+    for (size_t i = 0; i + 1 < hex.size(); i += 2)
+        out.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    return out;
+}
+static inline std::string bytes_to_hex(const std::vector<uint8_t>& bytes) {
+    std::ostringstream oss;
+    for (auto b : bytes)
+        oss << std::hex << std::setw(2) << std::setfill('0') << int(b);
+    return oss.str();
+}
+static inline bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+static inline auto now() { return std::chrono::high_resolution_clock::now(); }
+static inline double secs_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+static inline size_t current_rss_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+static inline double bytes_to_mb(size_t b) { return double(b) / (1024.0 * 1024.0); }
+
+// ------------------------- Data --------------------------
+// Contiguous blocks carved out of one vector; freed blocks are recycled by size.
+template <typename T>
+struct BlockPool {
+    std::vector<T> data;
+    std::vector<std::vector<uint32_t>> free_by_size;
+
+    uint32_t alloc(uint32_t n) {
+        if (n < free_by_size.size() && !free_by_size[n].empty()) {
+            uint32_t base = free_by_size[n].back();
+            free_by_size[n].pop_back();
+            return base;
+        }
+        uint32_t base = uint32_t(data.size());
+        data.resize(data.size() + n);
+        return base;
+    }
+    void release(uint32_t base, uint32_t n) {
+        if (n == 0) return;
+        if (free_by_size.size() <= n) free_by_size.resize(n + 1);
+        free_by_size[n].push_back(base);
+    }
+};
+
+template <int S>
+class TreeBitmap {
+    static_assert(S == 4 || S == 5 || S == 8, "stride must be 4, 5 or 8");
+    static constexpr int W = ((1 << S) + 63) / 64;   // 64-bit words per bitmap
+
+    struct Node {
+        uint64_t internal[W];   // bit (1<<l)|bits: prefix of length l inside the node
+        uint64_t external[W];   // bit c: child for stride value c exists
+        uint32_t child_base;
+        uint32_t result_base;
+    };
+
+public:
+    TreeBitmap() {
+        uint32_t root = nodes_.alloc(1);
+        nodes_.data[root] = Node{};
+    }
+
+    void insert(uint32_t net, uint8_t len, std::vector<uint8_t>&& key) {
+        net &= mask_from_len(len);
+        uint64_t k = uint64_t(net) << 32;
+        uint32_t n = 0;
+        int depth = 0;
+        while (len - depth >= S) {
+            uint32_t c = chunk(k, depth, S);
+            if (!test(nodes_.data[n].external, c)) add_child(n, c);
+            n = nodes_.data[n].child_base + rank(nodes_.data[n].external, c);
+            depth += S;
+        }
+        int l = len - depth;
+        uint32_t pos = (1u << l) | (l ? chunk(k, depth, l) : 0u);
+
+        keys_.push_back(std::move(key));
+        uint32_t id = uint32_t(keys_.size() - 1);
+        Node& nd = nodes_.data[n];
+        if (test(nd.internal, pos)) {
+            results_.data[nd.result_base + rank(nd.internal, pos)] = id;
+        } else {
+            add_result(n, pos, id);
+        }
+        ++inserted_;
+    }
+
+    const std::vector<uint8_t>* lpm(uint32_t ip) const {
+        const uint64_t k = uint64_t(ip) << 32;
+        const Node* nodes = nodes_.data.data();
+        const uint32_t* results = results_.data.data();
+        const uint32_t* best = nullptr;
+        uint32_t n = 0;
+        int depth = 0;
+        for (;;) {
+            const Node& nd = nodes[n];
+            uint32_t c = chunk(k, depth, S);
+            for (int l = S - 1; l >= 0; --l) {
+                uint32_t pos = (1u << l) | (c >> (S - l));
+                if (test(nd.internal, pos)) {
+                    best = &results[nd.result_base + rank(nd.internal, pos)];
+                    break;
+                }
+            }
+            if (!test(nd.external, c)) break;
+            n = nd.child_base + rank(nd.external, c);
+            depth += S;
+        }
+        return best ? &keys_[*best] : nullptr;
+    }
+
+    size_t inserted() const { return inserted_; }
+    size_t node_count() const { return nodes_.data.size(); }
+
+private:
+    BlockPool<Node> nodes_;
+    BlockPool<uint32_t> results_;
+    std::vector<std::vector<uint8_t>> keys_;
+    size_t inserted_ = 0;
+
+    // `bits` bits of the (zero-padded) address starting at bit `depth`
+    static inline uint32_t chunk(uint64_t k, int depth, int bits) {
+        return uint32_t((k << depth) >> (64 - bits));
+    }
+    static inline bool test(const uint64_t* bm, uint32_t i) {
+        return (bm[i >> 6] >> (i & 63)) & 1ULL;
+    }
+    // number of set bits strictly below i
+    static inline uint32_t rank(const uint64_t* bm, uint32_t i) {
+        uint32_t r = 0;
+        for (uint32_t w = 0; w < (i >> 6); ++w) r += uint32_t(__builtin_popcountll(bm[w]));
+        if (i & 63) r += uint32_t(__builtin_popcountll(bm[i >> 6] & ((1ULL << (i & 63)) - 1)));
+        return r;
+    }
+    static inline uint32_t count(const uint64_t* bm) {
+        uint32_t r = 0;
+        for (int w = 0; w < W; ++w) r += uint32_t(__builtin_popcountll(bm[w]));
+        return r;
+    }
+
+    // Re-home node n's children into a block one larger with an empty node at c.
+    void add_child(uint32_t n, uint32_t c) {
+        uint32_t old_n    = count(nodes_.data[n].external);
+        uint32_t old_base = nodes_.data[n].child_base;
+        uint32_t at       = rank(nodes_.data[n].external, c);
+        uint32_t base     = nodes_.alloc(old_n + 1);
+        Node* d = nodes_.data.data();
+        for (uint32_t i = 0; i < at; ++i)     d[base + i]     = d[old_base + i];
+        d[base + at] = Node{};
+        for (uint32_t i = at; i < old_n; ++i) d[base + i + 1] = d[old_base + i];
+        nodes_.release(old_base, old_n);
+        d[n].child_base = base;
+        d[n].external[c >> 6] |= 1ULL << (c & 63);
+    }
+
+    void add_result(uint32_t n, uint32_t pos, uint32_t id) {
+        Node& nd = nodes_.data[n];
+        uint32_t old_n    = count(nd.internal);
+        uint32_t old_base = nd.result_base;
+        uint32_t at       = rank(nd.internal, pos);
+        uint32_t base     = results_.alloc(old_n + 1);
+        uint32_t* d = results_.data.data();
+        for (uint32_t i = 0; i < at; ++i)     d[base + i]     = d[old_base + i];
+        d[base + at] = id;
+        for (uint32_t i = at; i < old_n; ++i) d[base + i + 1] = d[old_base + i];
+        results_.release(old_base, old_n);
+        nd.result_base = base;
+        nd.internal[pos >> 6] |= 1ULL << (pos & 63);
+    }
+};
+
+struct PrefixRec {
+    uint32_t net;
+    uint8_t len;
+    std::vector<uint8_t> key; // will be moved into trie
+};
+
+// ------------------------- Benchmark ---------------------
+template <int S>
+static int run(bool write_hex, int threads) {
+    // -------- Phase A: Load prefixes (batch) --------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream pf(PREFIX_FILE);
+    std::string line;
+    std::getline(pf, line); // header: prefix,key
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000);
+
+    size_t num_prefixes = 0;
+    while (std::getline(pf, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',') || !std::getline(ss, key_hex)) continue;
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        if (len > 32) continue;  // Skip invalid prefix lengths
+        uint32_t net = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        prefixes.push_back({net, len, hex_to_bytes(key_hex)});
+        ++num_prefixes;
+    }
+
+    double prefix_load_s = secs_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // -------- Phase B: Build trie (incremental inserts) --------
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+
+    TreeBitmap<S> trie;
+    for (auto& rec : prefixes) {
+        trie.insert(rec.net, rec.len, std::move(rec.key));
+    }
+    double build_ds_s = secs_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    size_t mem_ds_bytes = (rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+
+    prefixes.clear();
+    prefixes.shrink_to_fit();
+
+    // -------- Phase C: Load IPs (batch) --------
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipf(IP_FILE);
+    std::getline(ipf, line); // header: ip,used_prefix
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1<<20);
+    ip_strs.reserve(1<<20);
+
+    while (std::getline(ipf, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, dummy;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, dummy);
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = secs_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // -------- Phase D: Lookup timing --------
+    auto tD0 = now();
+    std::vector<std::pair<std::string,std::string>> results;
+    results.reserve(ips.size());
+
+    for (size_t i = 0; i < ips.size(); ++i) {
+        const auto* key = trie.lpm(ips[i]);
+        if (write_hex) {
+            results.emplace_back(ip_strs[i], key ? bytes_to_hex(*key) : std::string("-1"));
+        } else {
+            results.emplace_back(ip_strs[i], key ? std::string("1") : std::string("-1"));
+        }
+    }
+    double lookup_s = secs_since(tD0);
+
+    double ns_per_lookup = ips.empty() ? 0.0 : (lookup_s * 1e9 / double(ips.size()));
+    double lookups_per_s = (lookup_s > 0.0) ? (double(ips.size()) / lookup_s) : 0.0;
+
+    // -------- Write matches --------
+    {
+        std::ofstream out(MATCH_FILE, std::ios::binary);
+        if (!out) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (auto& r : results) out << r.first << "," << r.second << "\n";
+        }
+    }
+
+    // -------- Final mem & write results CSV --------
+    size_t rss_total_bytes = current_rss_bytes();
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ds_mb           = bytes_to_mb(mem_ds_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+    double mem_total_mb        = bytes_to_mb(rss_total_bytes);
+
+    std::string algo_name = "TreeBitmap-S" + std::to_string(S);
+    bool need_header = !file_exists(RESULTS_FILE);
+
+    std::ofstream res(RESULTS_FILE, std::ios::app);
+    if (!res) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        res.setf(std::ios::fixed);
+        if (need_header) {
+            res << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                   "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                   "lookups_per_s,ns_per_lookup,"
+                   "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb\n";
+        }
+        res << algo_name << ","
+            << PREFIX_FILE << ","
+            << IP_FILE << ","
+            << num_prefixes << ","
+            << ips.size() << ","
+            << std::setprecision(6)
+            << prefix_load_s << ","
+            << build_ds_s << ","
+            << ip_load_s << ","
+            << lookup_s << ","
+            << std::setprecision(2)
+            << lookups_per_s << ","
+            << ns_per_lookup << ","
+            << std::setprecision(2)
+            << mem_prefix_array_mb << ","
+            << mem_ds_mb << ","
+            << mem_ip_array_mb << ","
+            << mem_total_mb
+            << "\n";
+    }
+
+    // -------- Optional: multithreaded scaling run (--threads N) --------
+    if (threads > 0)
+        mt::run_threads_benchmark(algo_name, ips, threads,
+                                  [&](uint32_t ip) { return trie.lpm(ip) != nullptr; });
+
+    return 0;
+}
+
+// ------------------------- Main --------------------------
+int main(int argc, char* argv[]) {
+    bool write_hex = false;
+    int stride = 4;
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "-chk" || a == "--chk") write_hex = true;
+        else if ((a == "-s" || a == "--stride") && i + 1 < argc) stride = std::stoi(argv[++i]);
+        else if ((a == "-threads" || a == "--threads") && i + 1 < argc) threads = std::max(1, std::stoi(argv[++i]));
+        else if (a == "-h" || a == "--help") {
+            std::cout <<
+                "Usage: " << argv[0] << " [-chk] [-s 4|5|8] [--threads N]\n"
+                "  -chk          Write hex keys to benchmarks/match_tree_bitmap.csv (slower)\n"
+                "  -s            Stride in bits per node (4, 5 or 8; default 4)\n"
+                "  --threads N   Also measure lookup scaling on N pinned threads\n"
+                "                (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    switch (stride) {
+        case 4: return run<4>(write_hex, threads);
+        case 5: return run<5>(write_hex, threads);
+        case 8: return run<8>(write_hex, threads);
+        default:
+            std::cerr << "Error: unsupported stride " << stride << " (use 4, 5 or 8)\n";
+            return 1;
+    }
+}
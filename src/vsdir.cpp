@@ -0,0 +1,465 @@
+// Variable-stride DIR: a direct-indexed first level of S1 bits followed by
+// second/third-level blocks whose stride is chosen per region. S1/S2/S3 are
+// compile-time template parameters (24-4-4, 20-6-6, 16-8-8 covers the
+// DIR-24-8 / DXR-16-8-8 design space); within a region a block only gets as
+// many bits as its longest prefix needs, so a lone /26 under a /24 costs a
+// 4-entry block instead of 256 slots. Every configuration is built and timed
+// in one run and reported as its own results row.
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <iomanip>
+#include <chrono>
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <unistd.h>   // sysconf
+#include <cstdlib>    // aligned_alloc, exit
+#include "mt_lookup.h"
+
+// ------------------------- Config / constants -------------------------
+// Entry: BLOCK_FLAG clear -> key id (0 = no match)
+//        BLOCK_FLAG set   -> child block, stride in bits 26..30, pool offset in bits 0..25
+static const uint32_t BLOCK_FLAG   = 0x80000000u;
+static const int      STRIDE_SHIFT = 26;
+static const uint32_t OFFSET_MASK  = (1u << STRIDE_SHIFT) - 1;
+
+// File paths (relative to repo root)
+static const char* PREFIX_FILE   = "data/prefix_table.csv";
+static const char* IP_FILE       = "data/generated_ips.csv";
+static const char* MATCH_FILE    = "benchmarks/match_vsdir.csv";
+static const char* RESULTS_FILE  = "benchmarks/results_vsdir.csv";
+
+// ------------------------- Memory / timing helpers --------------------
+size_t current_rss_bytes() {
+    // Linux: /proc/self/statm (resident pages * page size)
+    std::ifstream statm("/proc/self/statm");
+    size_t size=0, resident=0;
+    if (statm) statm >> size >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+inline auto now() {
+    return std::chrono::high_resolution_clock::now();
+}
+inline double seconds_since(std::chrono::high_resolution_clock::time_point t0) {
+    return std::chrono::duration<double>(now() - t0).count();
+}
+inline double bytes_to_mb(size_t bytes) {
+    return static_cast<double>(bytes) / (1024.0 * 1024.0);
+}
+
+// ------------------------- Utilities ---------------------------------
+uint32_t ip_str_to_uint(const std::string& ip_str) {
+    in_addr addr{};
+    inet_pton(AF_INET, ip_str.c_str(), &addr);
+    return ntohl(addr.s_addr);
+}
+uint32_t mask_from_len(uint8_t len) {
+    return (len == 0) ? 0U : (~0U << (32 - len));
+}
+std::string bytes_to_hex(const uint8_t* key, int len = 64) {
+    std::ostringstream oss;
+    for (int i = 0; i < len; ++i) {
+        oss << std::hex << std::setw(2) << std::setfill('0')
+            << static_cast<int>(key[i]);
+    }
+    return oss.str();
+}
+bool file_exists(const char* path) {
+    std::ifstream f(path);
+    return f.good();
+}
+
+// ------------------------- Key handling -------------------------------
+// Keys are deduplicated into ids 1..N (0 = no key); after loading they are
+// packed into one 64-byte aligned array so an id maps to one cache line.
+std::unordered_map<std::string, uint32_t> g_key_ids;
+std::vector<uint8_t> g_key_bytes;     // 64 bytes per id, filled while loading
+uint8_t* g_key_array = nullptr;       // (num_keys + 1) x 64 bytes, aligned
+
+uint32_t get_or_create_key_id(const std::string& hex) {
+    if (hex.size() != 128) return 0;
+    auto it = g_key_ids.find(hex);
+    if (it != g_key_ids.end()) return it->second;
+
+    const uint32_t id = static_cast<uint32_t>(g_key_ids.size()) + 1;
+    for (size_t i = 0; i < 128; i += 2) {
+        g_key_bytes.push_back(static_cast<uint8_t>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+    }
+    g_key_ids.emplace(hex, id);
+    return id;
+}
+
+void build_key_array() {
+    const size_t num_keys = g_key_ids.size();
+    g_key_array = static_cast<uint8_t*>(std::aligned_alloc(64, (num_keys + 1) * 64));
+    std::memset(g_key_array, 0, 64);
+    if (num_keys) std::memcpy(g_key_array + 64, g_key_bytes.data(), num_keys * 64);
+    g_key_bytes.clear();
+    g_key_bytes.shrink_to_fit();
+}
+
+// ------------------------- Data structures ---------------------------
+struct PrefixRec {
+    uint32_t base_ip;  // aligned network address
+    uint8_t  len;      // prefix length
+    uint32_t key_id;   // index into g_key_array (0 = none)
+};
+
+template <int S1, int S2, int S3>
+struct VarStrideDir {
+    static_assert(S1 + S2 + S3 == 32, "strides must cover all 32 bits");
+    static_assert(S2 < 32 && S3 < 32 && S1 > 0, "invalid stride");
+
+    std::vector<uint32_t> l1;     // [2^S1]
+    std::vector<uint32_t> pool;   // every second/third-level block
+    size_t   l2_blocks = 0, l3_blocks = 0;
+    uint64_t l2_stride_sum = 0, l3_stride_sum = 0;
+
+    static std::string name() {
+        return std::to_string(S1) + "-" + std::to_string(S2) + "-" + std::to_string(S3);
+    }
+
+    uint32_t new_block(int stride) {
+        const size_t off = pool.size();
+        if (off + (size_t(1) << stride) > OFFSET_MASK) {
+            std::cerr << "Error: VS-DIR " << name() << " pool exceeds " << OFFSET_MASK << " entries\n";
+            std::exit(1);
+        }
+        pool.resize(off + (size_t(1) << stride), 0);
+        return BLOCK_FLAG | (static_cast<uint32_t>(stride) << STRIDE_SHIFT) | static_cast<uint32_t>(off);
+    }
+
+    // Writes id into every leaf under *slot (an entry covering `bits` leading
+    // bits) that the prefix covers. All blocks exist before painting starts,
+    // so pool pointers stay valid.
+    void paint(uint32_t* slot, int bits, uint32_t net, uint8_t len, uint32_t id) {
+        const uint32_t e = *slot;
+        if (!(e & BLOCK_FLAG)) {
+            if (len <= bits) *slot = id;
+            return;
+        }
+        const int k = static_cast<int>((e >> STRIDE_SHIFT) & 31);
+        uint32_t* block = pool.data() + (e & OFFSET_MASK);
+        uint32_t first = 0, count = 1u << k;
+        if (len > bits) {
+            first = (net << bits) >> (32 - k);
+            count = (len >= bits + k) ? 1u : (1u << (bits + k - len));
+        }
+        for (uint32_t i = 0; i < count; ++i) paint(block + first + i, bits + k, net, len, id);
+    }
+
+    // prefixes must be sorted by ascending length (stable, last duplicate wins)
+    void build(const std::vector<PrefixRec>& prefixes) {
+        l1.assign(size_t(1) << S1, 0);
+
+        // Longest prefix below each first-level slot and each full-stride
+        // second-level slot decides the stride of the block hung there.
+        std::vector<uint8_t> max1(size_t(1) << S1, 0);
+        std::unordered_map<uint32_t, uint8_t> max2;
+        for (const auto& rec : prefixes) {
+            if (rec.len > 32 || !rec.key_id) continue;
+            if (rec.len > S1) {
+                uint8_t& m = max1[rec.base_ip >> (32 - S1)];
+                m = std::max(m, rec.len);
+            }
+            if (rec.len > S1 + S2) {
+                uint8_t& m = max2[rec.base_ip >> (32 - S1 - S2)];
+                m = std::max(m, rec.len);
+            }
+        }
+        for (size_t i = 0; i < max1.size(); ++i) {
+            if (!max1[i]) continue;
+            const int k2 = std::min(S2, max1[i] - S1);
+            l1[i] = new_block(k2);
+            ++l2_blocks; l2_stride_sum += k2;
+        }
+        for (const auto& kv : max2) {
+            const uint32_t e2 = l1[kv.first >> S2];   // full S2 stride since max1 > S1 + S2
+            const size_t slot = (e2 & OFFSET_MASK) + (kv.first & ((1u << S2) - 1));
+            const int k3 = kv.second - S1 - S2;
+            const uint32_t child = new_block(k3);     // may grow pool: index, not reference
+            pool[slot] = child;
+            ++l3_blocks; l3_stride_sum += k3;
+        }
+        max1.clear(); max1.shrink_to_fit();
+
+        // Shortest first: longer prefixes overwrite what they cover.
+        for (const auto& rec : prefixes) {
+            if (rec.len > 32 || !rec.key_id) continue;
+            const uint32_t first = rec.base_ip >> (32 - S1);
+            const uint32_t count = (rec.len >= S1) ? 1u : (1u << (S1 - rec.len));
+            for (uint32_t i = 0; i < count; ++i) {
+                paint(&l1[first + i], S1, rec.base_ip, rec.len, rec.key_id);
+            }
+        }
+        pool.shrink_to_fit();
+    }
+
+    inline uint32_t lookup(uint32_t ip) const {
+        uint32_t e = l1[ip >> (32 - S1)];
+        if (e & BLOCK_FLAG) {
+            const int k = (e >> STRIDE_SHIFT) & 31;
+            e = pool[(e & OFFSET_MASK) + ((ip << S1) >> (32 - k))];
+            if (e & BLOCK_FLAG) {
+                const int k3 = (e >> STRIDE_SHIFT) & 31;
+                e = pool[(e & OFFSET_MASK) + ((ip << (S1 + S2)) >> (32 - k3))];
+            }
+        }
+        return e;
+    }
+
+    size_t bytes() const {
+        return (l1.size() + pool.size()) * sizeof(uint32_t);
+    }
+};
+
+struct ConfigResult {
+    std::string name;
+    double build_ds_s, lookup_s, lookups_per_s, ns_per_lookup, mem_ds_mb, mem_total_mb, struct_mb;
+    size_t l2_blocks, l3_blocks;
+    double avg_l2_stride, avg_l3_stride;
+};
+
+// Builds one stride configuration, runs every lookup, and frees it again.
+// ids receives the key id per IP (for the cross-check) and results the
+// "1"/"-1" or hex string, built inside Phase D as the other engines do.
+// Total RSS is sampled while the table is still live.
+// threads > 0 adds a multithreaded scaling run on the same table.
+template <int S1, int S2, int S3>
+ConfigResult run_config(const std::vector<PrefixRec>& prefixes, const std::vector<uint32_t>& ips,
+                        bool write_hex, std::vector<uint32_t>& ids,
+                        std::vector<std::string>& results, int threads) {
+    ConfigResult r{};
+    r.name = VarStrideDir<S1, S2, S3>::name();
+
+    auto tB0 = now();
+    size_t rssB0 = current_rss_bytes();
+    auto* dir = new VarStrideDir<S1, S2, S3>();
+    dir->build(prefixes);
+    r.build_ds_s = seconds_since(tB0);
+    size_t rssB1 = current_rss_bytes();
+    r.mem_ds_mb  = bytes_to_mb(rssB1 > rssB0 ? rssB1 - rssB0 : 0);
+    r.struct_mb  = bytes_to_mb(dir->bytes());
+    r.l2_blocks  = dir->l2_blocks;
+    r.l3_blocks  = dir->l3_blocks;
+    r.avg_l2_stride = dir->l2_blocks ? double(dir->l2_stride_sum) / double(dir->l2_blocks) : 0.0;
+    r.avg_l3_stride = dir->l3_blocks ? double(dir->l3_stride_sum) / double(dir->l3_blocks) : 0.0;
+
+    ids.resize(ips.size());
+    results.clear();
+    results.reserve(ips.size());
+    auto tD0 = now();
+    for (size_t i = 0; i < ips.size(); ++i) {
+        const uint32_t id = dir->lookup(ips[i]);
+        ids[i] = id;
+        if (!id)            results.emplace_back("-1");
+        else if (write_hex) results.emplace_back(bytes_to_hex(g_key_array + static_cast<size_t>(id) * 64));
+        else                results.emplace_back("1");
+    }
+    r.lookup_s = seconds_since(tD0);
+    r.ns_per_lookup = (ips.empty() ? 0.0 : (r.lookup_s * 1e9 / static_cast<double>(ips.size())));
+    r.lookups_per_s = (r.lookup_s > 0.0 ? (static_cast<double>(ips.size()) / r.lookup_s) : 0.0);
+
+    r.mem_total_mb = bytes_to_mb(current_rss_bytes());
+
+    if (threads > 0)
+        mt::run_threads_benchmark("VS-DIR-" + r.name, ips, threads, [&](uint32_t ip) { return dir->lookup(ip) != 0; });
+
+    delete dir;
+    return r;
+}
+
+// ------------------------- Main --------------------------------------
+int main(int argc, char* argv[]) {
+    // Check for -chk flag to output hex keys
+    bool write_hex = false;
+    std::string only;   // empty = all configurations
+    int threads = 0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-chk" || arg == "--chk") {
+            write_hex = true;
+        } else if ((arg == "-s" || arg == "--strides") && i + 1 < argc) {
+            only = argv[++i];
+            if (only != "24-4-4" && only != "20-6-6" && only != "16-8-8") {
+                std::cerr << "Error: unknown stride configuration '" << only << "'\n";
+                return 1;
+            }
+        } else if ((arg == "-threads" || arg == "--threads") && i + 1 < argc) {
+            threads = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "-h" || arg == "--help") {
+            std::cout << "Usage: " << argv[0] << " [-chk] [-s 24-4-4|20-6-6|16-8-8] [--threads N]\n"
+                      << "  -chk   Write hex keys to match file (slower)\n"
+                      << "  -s     Run a single stride configuration (default: all)\n"
+                      << "  --threads N  Also measure lookup scaling on N pinned threads per\n"
+                      << "               configuration (appends to benchmarks/results_threads.csv)\n";
+            return 0;
+        }
+    }
+
+    // ----------------- Phase A: Load Prefixes (batch) -----------------
+    if (!file_exists(PREFIX_FILE)) {
+        std::cerr << "Error: cannot open " << PREFIX_FILE << "\n";
+        return 1;
+    }
+
+    auto tA0 = now();
+    size_t rssA0 = current_rss_bytes();
+
+    std::ifstream fib(PREFIX_FILE);
+    std::string line;
+    std::getline(fib, line); // skip header "prefix,key"
+
+    std::vector<PrefixRec> prefixes;
+    prefixes.reserve(200000); // guess; adjust as needed
+
+    size_t num_prefixes = 0;
+    while (std::getline(fib, line)) {
+        std::istringstream ss(line);
+        std::string prefix_str, key_hex;
+        if (!std::getline(ss, prefix_str, ',')) continue;
+        if (!std::getline(ss, key_hex)) continue;
+
+        auto slash = prefix_str.find('/');
+        if (slash == std::string::npos) continue;
+
+        std::string ip_part = prefix_str.substr(0, slash);
+        uint8_t len = static_cast<uint8_t>(std::stoi(prefix_str.substr(slash + 1)));
+        uint32_t base_ip = ip_str_to_uint(ip_part) & mask_from_len(len);
+
+        prefixes.push_back({base_ip, len, get_or_create_key_id(key_hex)});
+        ++num_prefixes;
+    }
+    build_key_array();
+    std::stable_sort(prefixes.begin(), prefixes.end(),
+                     [](const PrefixRec& a, const PrefixRec& b) { return a.len < b.len; });
+
+    double prefix_load_s = seconds_since(tA0);
+    size_t rssA1 = current_rss_bytes();
+    size_t mem_prefix_array_bytes = (rssA1 > rssA0 ? rssA1 - rssA0 : 0);
+
+    // ----------------- Phase C: Load IPs (batch) ----------------------
+    // Loaded before the builds so every configuration runs the same batch.
+    if (!file_exists(IP_FILE)) {
+        std::cerr << "Error: cannot open " << IP_FILE << "\n";
+        return 1;
+    }
+
+    auto tC0 = now();
+    size_t rssC0 = current_rss_bytes();
+
+    std::ifstream ipfile(IP_FILE);
+    std::getline(ipfile, line); // skip header "ip,used_prefix"
+
+    std::vector<uint32_t> ips;
+    std::vector<std::string> ip_strs;
+    ips.reserve(1000000); ip_strs.reserve(1000000); // guess; adjust as needed
+
+    while (std::getline(ipfile, line)) {
+        std::istringstream ss(line);
+        std::string ip_str, discard;
+        if (!std::getline(ss, ip_str, ',')) continue;
+        std::getline(ss, discard); // used_prefix (ignored for speed)
+        ip_strs.push_back(ip_str);
+        ips.push_back(ip_str_to_uint(ip_str));
+    }
+
+    double ip_load_s = seconds_since(tC0);
+    size_t rssC1 = current_rss_bytes();
+    size_t mem_ip_array_bytes = (rssC1 > rssC0 ? rssC1 - rssC0 : 0);
+
+    // ----------------- Phase B + D: Build and lookup per config -------
+    // The match file comes from the first configuration; any configuration
+    // that disagrees with it makes the run exit non-zero.
+    std::vector<ConfigResult> runs;
+    std::vector<uint32_t> ids, first_ids;
+    std::vector<std::string> results, first_results;
+    bool disagree = false;
+    auto record = [&](ConfigResult r) {
+        if (runs.empty()) {
+            first_ids.swap(ids);
+            first_results.swap(results);
+        } else if (ids != first_ids) {
+            std::cerr << "Error: VS-DIR " << r.name << " disagrees with " << runs[0].name << "\n";
+            disagree = true;
+        }
+        runs.push_back(r);
+    };
+    if (only.empty() || only == "24-4-4") record(run_config<24, 4, 4>(prefixes, ips, write_hex, ids, results, threads));
+    if (only.empty() || only == "20-6-6") record(run_config<20, 6, 6>(prefixes, ips, write_hex, ids, results, threads));
+    if (only.empty() || only == "16-8-8") record(run_config<16, 8, 8>(prefixes, ips, write_hex, ids, results, threads));
+
+    // ----------------- Output matches -------------------------------
+    {
+        std::ofstream out(MATCH_FILE);
+        if (!out.is_open()) {
+            std::cerr << "Error: cannot open " << MATCH_FILE << " for writing\n";
+        } else {
+            out << "ip,key\n";
+            for (size_t i = 0; i < ips.size(); ++i) {
+                out << ip_strs[i] << "," << first_results[i] << "\n";
+            }
+        }
+    }
+
+    // Convert memory to MB for output (mem_total_mb is per configuration)
+    double mem_prefix_array_mb = bytes_to_mb(mem_prefix_array_bytes);
+    double mem_ip_array_mb     = bytes_to_mb(mem_ip_array_bytes);
+
+    // ----------------- Append metrics CSV ---------------------------
+    // One row per stride configuration. Columns:
+    // algorithm,prefix_file,ip_file,num_prefixes,num_ips,
+    // prefix_load_s,build_ds_s,ip_load_s,lookup_s,lookups_per_s,ns_per_lookup,
+    // mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,
+    // strides,l2_blocks,l3_blocks,avg_l2_stride,avg_l3_stride,vsdir_struct_mb
+    bool write_header = !file_exists(RESULTS_FILE);
+    std::ofstream r(RESULTS_FILE, std::ios::app);
+    if (!r.is_open()) {
+        std::cerr << "Error: cannot open " << RESULTS_FILE << " for writing\n";
+    } else {
+        r.setf(std::ios::fixed);
+        if (write_header) {
+            r << "algorithm,prefix_file,ip_file,num_prefixes,num_ips,"
+                 "prefix_load_s,build_ds_s,ip_load_s,lookup_s,"
+                 "lookups_per_s,ns_per_lookup,"
+                 "mem_prefix_array_mb,mem_ds_mb,mem_ip_array_mb,mem_total_mb,"
+                 "strides,l2_blocks,l3_blocks,avg_l2_stride,avg_l3_stride,vsdir_struct_mb\n";
+        }
+        for (const auto& run : runs) {
+            r << "VS-DIR-" << run.name << ","
+              << PREFIX_FILE << ","
+              << IP_FILE << ","
+              << num_prefixes << ","
+              << ips.size() << ","
+              << std::setprecision(6)
+              << prefix_load_s << ","
+              << run.build_ds_s << ","
+              << ip_load_s << ","
+              << run.lookup_s << ","
+              << std::setprecision(2) << run.lookups_per_s << ","
+              << std::setprecision(2) << run.ns_per_lookup << ","
+              << std::setprecision(2)
+              << mem_prefix_array_mb << ","
+              << run.mem_ds_mb << ","
+              << mem_ip_array_mb << ","
+              << run.mem_total_mb << ","
+              << run.name << ","
+              << run.l2_blocks << ","
+              << run.l3_blocks << ","
+              << run.avg_l2_stride << ","
+              << run.avg_l3_stride << ","
+              << run.struct_mb
+              << "\n";
+        }
+    }
+
+    // ----------------- Cleanup -------------------------------------
+    std::free(g_key_array);
+
+    return disagree ? 1 : 0;
+}
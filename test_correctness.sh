@@ -21,6 +21,20 @@ declare -A algorithms=(
     ["dir24_8"]="benchmarks/match_dir24_8.csv"
     ["dxr"]="benchmarks/match_dxr.csv"
     ["dxr_bloom"]="benchmarks/match_dxr_bloom.csv"
+    ["dxr_range"]="benchmarks/match_dxr_range.csv"
+    ["poptrie"]="benchmarks/match_poptrie.csv"
+    ["tree_bitmap"]="benchmarks/match_tree_bitmap.csv"
+    ["lc_trie"]="benchmarks/match_lc.csv"
+    ["sail"]="benchmarks/match_sail.csv"
+    ["lulea"]="benchmarks/match_lulea.csv"
+    ["bspl"]="benchmarks/match_bspl.csv"
+    ["bloom_lpm"]="benchmarks/match_bloom_lpm.csv"
+    ["eytzinger"]="benchmarks/match_eytzinger.csv"
+    ["stree"]="benchmarks/match_stree.csv"
+    ["art"]="benchmarks/match_art.csv"
+    ["learned"]="benchmarks/match_learned.csv"
+    ["dir24_8_tagged"]="benchmarks/match_dir24_8_tagged.csv"
+    ["vsdir"]="benchmarks/match_vsdir.csv"
     ["radix_trie_C"]="benchmarks/match_radix_C.csv"
 )
 
@@ -43,6 +57,48 @@ for algo in "${!algorithms[@]}"; do
         dxr_bloom)
             bin="src/dxr_bloom.out"
             ;;
+        dxr_range)
+            bin="src/dxr_range.out"
+            ;;
+        poptrie)
+            bin="src/poptrie.out"
+            ;;
+        tree_bitmap)
+            bin="src/tree_bitmap.out"
+            ;;
+        lc_trie)
+            bin="src/lc_trie.out"
+            ;;
+        sail)
+            bin="src/sail.out"
+            ;;
+        lulea)
+            bin="src/lulea.out"
+            ;;
+        bspl)
+            bin="src/bspl.out"
+            ;;
+        bloom_lpm)
+            bin="src/bloom_lpm.out"
+            ;;
+        eytzinger)
+            bin="src/eytzinger.out"
+            ;;
+        stree)
+            bin="src/stree.out"
+            ;;
+        art)
+            bin="src/art.out"
+            ;;
+        learned)
+            bin="src/learned.out"
+            ;;
+        dir24_8_tagged)
+            bin="src/dir24_8_tagged.out"
+            ;;
+        vsdir)
+            bin="src/vsdir.out"
+            ;;
         radix_trie_C)
             bin="src/radix_trie_C.out"
             if [ ! -f "$bin" ]; then
@@ -120,6 +176,146 @@ for algo in "${!algorithms[@]}"; do
                 continue
             fi
             ;;
+        dxr_range)
+            bin="src/dxr_range.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        poptrie)
+            bin="src/poptrie.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        tree_bitmap)
+            bin="src/tree_bitmap.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        lc_trie)
+            bin="src/lc_trie.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        sail)
+            bin="src/sail.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        lulea)
+            bin="src/lulea.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        bspl)
+            bin="src/bspl.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        bloom_lpm)
+            bin="src/bloom_lpm.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        eytzinger)
+            bin="src/eytzinger.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        stree)
+            bin="src/stree.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        art)
+            bin="src/art.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        learned)
+            bin="src/learned.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        dir24_8_tagged)
+            bin="src/dir24_8_tagged.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
+        vsdir)
+            bin="src/vsdir.out"
+            if [ -f "$bin" ]; then
+                echo "  Running $bin -chk..."
+                "$bin" -chk > /dev/null 2>&1 || echo "  ERROR: Execution failed"
+            else
+                echo "  SKIP: Binary not found"
+                continue
+            fi
+            ;;
         radix_trie_C)
             bin="src/radix_trie_C.out"
             if [ ! -f "$bin" ]; then